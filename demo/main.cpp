@@ -1,48 +1,116 @@
 #include "Fluid.h"
+#include "Recorder.h"
+#include <cerrno>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 #include <thread>
 #include <chrono>
 
 // Simple function to visualize the smoke (for demonstration purposes)
-void visualize(const FluidSimulation& fluid) {
+void visualize(const QP::FluidSimulation& fluid, std::string& frame, std::ostream& out) {
     const auto& grid = fluid.getGrid();
+
+    // Build the whole frame first; one write per frame instead of one flush per line.
+    frame.clear();
     for (int y = 0; y < 20; ++y) {
         for (int x = 0; x < 40; ++x) {
             if (grid[x][y].obstacle) {
-                std::cout << "X";
+                frame += 'X';
             } else {
                 float smoke = grid[x][y].smoke;
                 if (smoke > 0.5f) {
-                    std::cout << "#";
+                    frame += '#';
                 } else if (smoke > 0.1f) {
-                    std::cout << "+";
+                    frame += '+';
                 } else {
-                    std::cout << ".";
+                    frame += '.';
                 }
             }
         }
-        std::cout << std::endl;
+        frame += '\n';
     }
+    out << frame;
 }
 
-int main() {
-    FluidSimulation fluid(80, 40);
+// Usage: demo [--record <file|->] [--headless] [--frames N]
+int main(int argc, char** argv) {
+    std::string recordPath;
+    bool headless = false;
+    long maxFrames = -1;
+    bool badArguments = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            const std::string value = argv[++i];
+            char* end = nullptr;
+            errno = 0;
+            const long n = std::strtol(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0' || errno == ERANGE || n < 0) {
+                std::cerr << "--frames expects a non-negative integer, got '" << value << "'\n";
+                badArguments = true;
+            } else {
+                maxFrames = n;
+            }
+        }
+    }
+
+    if (badArguments) {
+        std::cerr << "Usage: demo [--record <file|->] [--headless] [--frames N]\n";
+        return 1;
+    }
 
-    int frame = 0;
-    while (true) {
+    QP::FluidSimulation fluid(80, 40);
+
+    QP::FrameRecorder recorder(fluid.width, fluid.height);
+    if (!recordPath.empty() && !recorder.open(recordPath)) {
+        std::cerr << "Could not open " << recordPath << " for recording\n";
+        return 1;
+    }
+    const bool recording = !recordPath.empty();
+    // Recording to stdout leaves the terminal output to stderr so the stream stays intact.
+    std::ostream& display = recordPath == "-" ? std::cerr : std::cout;
+
+    std::string buffer;
+    long frame = 0;
+    while (maxFrames < 0 || frame < maxFrames) {
         float dt = 0.1f;
 
-        
-        
+
+
         fluid.addSmoke(20, 10, 0.1f);
         fluid.addVelocity(20, 10, 0.1f, 0.0f);
 
         fluid.update(dt);
 
-        visualize(fluid);
-        std::cout << "Frame: " << frame++ << std::endl;
+        if (recording) {
+            if (!recorder.isOpen()) {
+                std::cerr << "Writing to " << recordPath << " failed, stopping\n";
+                break;
+            }
+            recorder.record(fluid);
+        }
+
+        ++frame;
+        if (headless) continue;
+
+        visualize(fluid, buffer, display);
+        display << "Frame: " << frame - 1 << '\n' << std::flush;
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
+    if (recording) {
+        recorder.close();
+        QP::RecorderStats stats = recorder.stats();
+        std::cerr << "Recorded " << stats.frames << " frames, " << stats.encodedBytes << " of "
+                  << stats.rawBytes << " raw bytes\n";
+        if (stats.writeFailed) return 1;
+    }
+
     return 0;
 }
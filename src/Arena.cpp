@@ -0,0 +1,102 @@
+#include "Arena.h"
+
+#include <algorithm>
+
+namespace QP {
+
+    FrameArena::FrameArena(size_t chunkSize) : chunkSize(chunkSize) {
+    }
+
+    void FrameArena::addChunk(size_t minimum) {
+        size_t size = std::max(chunkSize, minimum);
+        chunks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[size]), size });
+        counters.capacity += size;
+        counters.heapAllocations++;
+    }
+
+    void* FrameArena::allocate(size_t bytes, size_t alignment) {
+        if (bytes == 0) bytes = 1;
+
+        while (true) {
+            if (current < chunks.size()) {
+                Chunk& chunk = chunks[current];
+                uintptr_t base = reinterpret_cast<uintptr_t>(chunk.memory.get());
+                uintptr_t aligned = (base + offset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+                size_t end = static_cast<size_t>(aligned - base) + bytes;
+
+                if (end <= chunk.size) {
+                    counters.bytesInUse += end - offset;
+                    counters.peakBytes = std::max(counters.peakBytes, counters.bytesInUse);
+                    counters.allocations++;
+                    offset = end;
+                    return reinterpret_cast<void*>(aligned);
+                }
+
+                if (current + 1 < chunks.size()) {
+                    ++current;
+                    offset = 0;
+                    continue;
+                }
+            }
+
+            addChunk(bytes + alignment);
+            current = chunks.size() - 1;
+            offset = 0;
+        }
+    }
+
+    void FrameArena::reset() {
+        if (chunks.size() > 1) {
+            size_t total = counters.capacity;
+            chunks.clear();
+            counters.capacity = 0;
+            addChunk(total);
+        }
+
+        current = 0;
+        offset = 0;
+        counters.bytesInUse = 0;
+        counters.allocations = 0;
+        counters.resets++;
+    }
+
+
+    BlockPool::BlockPool(size_t blockSize, size_t blocksPerChunk)
+        : size(std::max(blockSize, sizeof(FreeBlock))), blocksPerChunk(std::max<size_t>(blocksPerChunk, 1)) {
+        // Keep every block suitably aligned for any object that fits in it.
+        size = (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    }
+
+    void* BlockPool::allocate() {
+        if (!freeList) {
+            uint8_t* chunk = new uint8_t[size * blocksPerChunk];
+            chunks.emplace_back(chunk);
+            counters.capacity += size * blocksPerChunk;
+            counters.heapAllocations++;
+
+            for (size_t i = blocksPerChunk; i-- > 0;) {
+                FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * size);
+                block->next = freeList;
+                freeList = block;
+            }
+        }
+
+        FreeBlock* block = freeList;
+        freeList = block->next;
+
+        counters.bytesInUse += size;
+        counters.peakBytes = std::max(counters.peakBytes, counters.bytesInUse);
+        counters.allocations++;
+        return block;
+    }
+
+    void BlockPool::deallocate(void* block) {
+        if (!block) return;
+
+        FreeBlock* freed = static_cast<FreeBlock*>(block);
+        freed->next = freeList;
+        freeList = freed;
+        counters.bytesInUse -= size;
+    }
+
+} // namespace QP
@@ -0,0 +1,162 @@
+/// Scratch memory for per-step temporaries.
+///
+/// FrameArena is a bump allocator: allocations are a pointer increment and
+/// reset() releases everything at once. After the first few steps the arena
+/// has grown to the step's peak and stepping no longer touches the heap.
+/// BlockPool hands out fixed-size blocks from a free list for node-based
+/// containers. Neither is thread-safe; use one per thread.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace QP {
+
+    struct AllocatorStats {
+        size_t bytesInUse{0};
+        size_t peakBytes{0};
+        size_t capacity{0};
+        size_t allocations{0};     ///< since the last reset
+        size_t heapAllocations{0}; ///< chunks requested from the system, ever
+        size_t resets{0};
+    };
+
+    class FrameArena {
+    public:
+        explicit FrameArena(size_t chunkSize = 1 << 20);
+
+        /// Arena contents are per-frame scratch, never state: a copy starts
+        /// empty with the same chunk size, so owners stay copyable.
+        FrameArena(const FrameArena& other) : chunkSize(other.chunkSize) {}
+        FrameArena& operator=(const FrameArena& other) {
+            chunkSize = other.chunkSize;
+            return *this;
+        }
+        FrameArena(FrameArena&&) = default;
+        FrameArena& operator=(FrameArena&&) = default;
+
+        void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+        /// Uninitialized storage for count objects of trivially constructible T.
+        template<typename T>
+        T* allocate(size_t count) {
+            return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+        }
+
+        /// Releases every allocation. When the last frame spilled into extra
+        /// chunks they are merged into one, so steady state is a single chunk.
+        void reset();
+
+        const AllocatorStats& stats() const { return counters; }
+
+    private:
+        struct Chunk {
+            std::unique_ptr<uint8_t[]> memory;
+            size_t size;
+        };
+
+        void addChunk(size_t minimum);
+
+        std::vector<Chunk> chunks;
+        size_t current{0};
+        size_t offset{0};
+        size_t chunkSize;
+        AllocatorStats counters;
+    };
+
+    class BlockPool {
+    public:
+        BlockPool(size_t blockSize, size_t blocksPerChunk = 256);
+
+        BlockPool(const BlockPool&) = delete;
+        BlockPool& operator=(const BlockPool&) = delete;
+
+        void* allocate();
+        void deallocate(void* block);
+
+        size_t blockSize() const { return size; }
+        const AllocatorStats& stats() const { return counters; }
+
+    private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        size_t size;
+        size_t blocksPerChunk;
+        FreeBlock* freeList{nullptr};
+        std::vector<std::unique_ptr<uint8_t[]>> chunks;
+        AllocatorStats counters;
+    };
+
+    /// STL adapter drawing from a FrameArena. deallocate() is a no-op; memory
+    /// comes back when the arena is reset, so containers must not outlive it.
+    template<typename T>
+    class ArenaAllocator {
+    public:
+        using value_type = T;
+
+        explicit ArenaAllocator(FrameArena& arena) noexcept : arena(&arena) {}
+
+        template<typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+        T* allocate(size_t n) { return arena->allocate<T>(n); }
+        void deallocate(T*, size_t) noexcept {}
+
+        template<typename U>
+        bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena == other.arena; }
+        template<typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena != other.arena; }
+
+    private:
+        template<typename U> friend class ArenaAllocator;
+        FrameArena* arena;
+    };
+
+    template<typename T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+    /// STL adapter for node-based containers. Single-object allocations that
+    /// fit the pool's block size come from the pool; anything else (bucket
+    /// arrays, oversized nodes) falls back to the heap.
+    template<typename T>
+    class PoolAllocator {
+    public:
+        using value_type = T;
+
+        explicit PoolAllocator(BlockPool& pool) noexcept : pool(&pool) {}
+
+        template<typename U>
+        PoolAllocator(const PoolAllocator<U>& other) noexcept : pool(other.pool) {}
+
+        T* allocate(size_t n) {
+            if (fromPool(n)) return static_cast<T*>(pool->allocate());
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, size_t n) noexcept {
+            if (fromPool(n)) pool->deallocate(p);
+            else ::operator delete(p);
+        }
+
+        template<typename U>
+        bool operator==(const PoolAllocator<U>& other) const noexcept { return pool == other.pool; }
+        template<typename U>
+        bool operator!=(const PoolAllocator<U>& other) const noexcept { return pool != other.pool; }
+
+    private:
+        template<typename U> friend class PoolAllocator;
+
+        bool fromPool(size_t n) const noexcept {
+            return n == 1 && sizeof(T) <= pool->blockSize() && alignof(T) <= alignof(std::max_align_t);
+        }
+
+        BlockPool* pool;
+    };
+
+} // namespace QP
@@ -41,7 +41,7 @@ namespace QP {
 		/// Create particles
 		for(size_t y = 0; y < height; ++y)
 			for(size_t x = 0; x < width; ++x)
-				particles.emplace_back(x * 0.1f, y * 0.1f);
+				particles.emplace_back(x * restLength, y * restLength);
 		
 		for(size_t y = 0; y < height; ++y)
 			for(size_t x = 0; x < width; ++x){
@@ -53,28 +53,39 @@ namespace QP {
 
 		particles[0].isStatic = true;
 		particles[width - 1].isStatic = true;
+
+		buildIslands();
 	}
 
 	void Cloth::applyGravity()
 	{
 		Vec2 gravity = {0.0f, -9.81f};
-		for (auto& particle : particles)
+		for (const auto& island : islands)
 		{
-			if (particle.isStatic) continue;
-			particle.applyForce(gravity);
-
+			if (island.sleeping) continue;
+			for (int index : island.particles)
+			{
+				Particle& particle = particles[index];
+				if (particle.isStatic) continue;
+				particle.applyForce(gravity);
+			}
 		}
 			
 	}
 
 	void Cloth::applyForce(const Vec2& force)
 	{
+		if (force.x != 0.0f || force.y != 0.0f)
+			wake();
+
 		for (auto& particle : particles)
 			particle.applyForce(force);
 	}
 
 	void Cloth::applyMouseForce(const Vec2& force)
 	{
+		wake();
+
 		for (auto& particle : particles)
 		{
 			Vec2 dir = force - particle.position;
@@ -85,22 +96,144 @@ namespace QP {
 
 	void Cloth::update(float ts)
 	{
+		if (isSleeping()) return;
+
 		applyGravity();
-		for (auto& particle : particles)
-			particle.update(ts);
-			
 
-		// Resolve constraints
-		for(int i = 0; i < 2500; ++i)
-			for(const auto& constraint : constraints)
-				resolveConstraint(constraint.first, constraint.second);
+		if (integrator == ClothIntegrator::Implicit)
+		{
+			implicitSolver.step(*this, ts);
+			for (auto& island : islands)
+				if (!island.sleeping) updateSleep(island, ts);
+			return;
+		}
+
+		for (const auto& island : islands)
+		{
+			if (island.sleeping) continue;
+			for (int index : island.particles)
+				particles[index].update(ts);
+		}
+
+		// Resolve constraints; islands share no particles, so each can be relaxed on its own.
+		for (auto& island : islands)
+		{
+			if (island.sleeping) continue;
+
+			for(int i = 0; i < 2500; ++i)
+				for(int c : island.constraints)
+					resolveConstraint(constraints[c].first, constraints[c].second);
+
+			updateSleep(island, ts);
+		}
+	}
+
+	void Cloth::buildIslands()
+	{
+		// Union-find over constraints.
+		std::vector<int> parent(particles.size());
+		for (size_t i = 0; i < parent.size(); ++i)
+			parent[i] = static_cast<int>(i);
+
+		auto find = [&](int i) {
+			while (parent[i] != i)
+			{
+				parent[i] = parent[parent[i]];
+				i = parent[i];
+			}
+			return i;
+		};
+
+		for (const auto& constraint : constraints)
+			parent[find(constraint.first)] = find(constraint.second);
+
+		islands.clear();
+		islandOf.assign(particles.size(), -1);
+		std::vector<int> islandOfRoot(particles.size(), -1);
+
+		for (size_t i = 0; i < particles.size(); ++i)
+		{
+			int root = find(static_cast<int>(i));
+			if (islandOfRoot[root] < 0)
+			{
+				islandOfRoot[root] = static_cast<int>(islands.size());
+				islands.emplace_back();
+			}
+			islandOf[i] = islandOfRoot[root];
+			islands[islandOf[i]].particles.push_back(static_cast<int>(i));
+		}
+
+		for (size_t c = 0; c < constraints.size(); ++c)
+			islands[islandOf[constraints[c].first]].constraints.push_back(static_cast<int>(c));
+	}
+
+	void Cloth::updateSleep(ClothIsland& island, float ts)
+	{
+		const float maxStep = sleepVelocity * ts;
+		bool resting = true;
+
+		for (int index : island.particles)
+		{
+			const Particle& particle = particles[index];
+			if ((particle.position - particle.oldPosition).length() > maxStep)
+			{
+				resting = false;
+				break;
+			}
+		}
+
+		float error = 0.0f;
+		for (int c : island.constraints)
+		{
+			const auto& constraint = constraints[c];
+			float distance = (particles[constraint.second].position - particles[constraint.first].position).length();
+			error += std::abs(distance - restLength);
+		}
+		if (std::abs(error - island.constraintError) > sleepError)
+			resting = false;
+		island.constraintError = error;
+
+		island.restFrames = resting ? island.restFrames + 1 : 0;
+		if (island.restFrames < sleepFrames) return;
+
+		// Freeze in place: no residual Verlet velocity or pending force on wake-up.
+		island.sleeping = true;
+		for (int index : island.particles)
+		{
+			particles[index].oldPosition = particles[index].position;
+			particles[index].acceleration = { 0, 0 };
+		}
+	}
+
+	void Cloth::wake()
+	{
+		for (auto& island : islands)
+		{
+			island.sleeping = false;
+			island.restFrames = 0;
+		}
+	}
+
+	void Cloth::wakeParticle(int index)
+	{
+		if (index < 0 || static_cast<size_t>(index) >= islandOf.size()) return;
+
+		ClothIsland& island = islands[islandOf[index]];
+		island.sleeping = false;
+		island.restFrames = 0;
+	}
+
+	bool Cloth::isSleeping() const
+	{
+		for (const auto& island : islands)
+			if (!island.sleeping) return false;
+		return true;
 	}
 
 	void Cloth::resolveConstraint(int a, int b)
 	{
 		Vec2 delta = particles[b].position - particles[a].position;
 		float distance = std::sqrt(delta.x * delta.x + delta.y * delta.y);
-		float restLength = 0.1f;
 
 		if(distance != restLength)
 		{
@@ -112,5 +245,14 @@ namespace QP {
 		}
 	}
 
+	void CaptureFrame(const Cloth& cloth, ClothFrame& frame)
+	{
+		frame.width = cloth.width;
+		frame.height = cloth.height;
+		frame.positions.resize(cloth.particles.size());
+		for (size_t i = 0; i < cloth.particles.size(); ++i)
+			frame.positions[i] = cloth.particles[i].position;
+	}
+
 
 } // namespace QP
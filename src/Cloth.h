@@ -8,6 +8,7 @@
 
 #include "Vector.h"
 #include "Timestep.h"
+#include "ClothImplicit.h"
 
 namespace QP {
 
@@ -28,6 +29,25 @@ namespace QP {
 
     };
 
+    /// Particles connected through constraints; an island sleeps and wakes as a whole.
+    struct ClothIsland {
+        std::vector<int> particles;
+        std::vector<int> constraints;
+        float constraintError{0.0f};
+        int restFrames{0};
+        bool sleeping{false};
+    };
+
+    enum class ClothIntegrator {
+        Verlet,     ///< explicit Verlet plus repeated constraint projection
+        Implicit    ///< backward Euler springs, see ClothImplicitSolver
+    };
+
+    struct ClothFrame {
+        size_t width{0}, height{0};
+        std::vector<Vec2> positions;
+    };
+
     class Cloth {
     public:
         Cloth(size_t width, size_t height);
@@ -39,11 +59,49 @@ namespace QP {
         void applyMouseForce(const Vec2& force);
         
         void resolveConstraint(int a, int b);
+
+        /// Recomputes islands from constraints; call after editing particles or constraints.
+        void buildIslands();
+
+        /// Wakes everything, or just the island containing a particle (e.g. on contact).
+        void wake();
+        void wakeParticle(int index);
+        bool isSleeping() const;
+
     
     public:
 	std::vector<Particle> particles;
 	std::vector<std::pair<int, int>> constraints;
     size_t width, height;
+
+    std::vector<ClothIsland> islands;
+    std::vector<int> islandOf;
+
+    float restLength{0.1f};
+
+    ClothIntegrator integrator{ClothIntegrator::Verlet};
+    /// Implicit mode only: spring stiffness and damping per constraint, mass per
+    /// particle, and the CG stopping criteria (relative residual, iteration cap).
+    float stiffness{2000.0f};
+    float damping{0.5f};
+    float particleMass{0.01f};
+    float solverTolerance{1e-4f};
+    int solverIterations{200};
+    ClothImplicitSolver implicitSolver;
+
+    /// An island falls asleep once its particles move slower than sleepVelocity
+    /// and its total constraint error changes by less than sleepError per update,
+    /// for sleepFrames updates in a row. The error itself is not required to
+    /// vanish: under gravity the relaxation settles with a constant residual.
+    float sleepVelocity{0.01f};
+    float sleepError{0.001f};
+    int sleepFrames{60};
+
+    private:
+    void updateSleep(ClothIsland& island, float ts);
     };
 
+    /// Particle positions, for Publisher<ClothFrame>.
+    void CaptureFrame(const Cloth& cloth, ClothFrame& frame);
+
 } // namespace QP
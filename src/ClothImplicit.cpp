@@ -0,0 +1,299 @@
+#include "ClothImplicit.h"
+#include "Cloth.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace QP {
+
+    namespace {
+
+        /// Rows per parallel chunk: small enough that mid-sized cloths spread
+        /// over the pool, large enough to amortize a task claim. Reductions sum
+        /// fixed chunks in order, so results do not depend on the thread count.
+        constexpr size_t RowChunk = 512;
+
+        Vec2 operator*(const Mat2& m, const Vec2& v) {
+            return Vec2(m.xx * v.x + m.xy * v.y, m.yx * v.x + m.yy * v.y);
+        }
+
+        void operator+=(Mat2& a, const Mat2& b) {
+            a.xx += b.xx; a.xy += b.xy;
+            a.yx += b.yx; a.yy += b.yy;
+        }
+
+        void operator-=(Mat2& a, const Mat2& b) {
+            a.xx -= b.xx; a.xy -= b.xy;
+            a.yx -= b.yx; a.yy -= b.yy;
+        }
+
+        Mat2 Identity(float s) {
+            Mat2 m;
+            m.xx = s;
+            m.yy = s;
+            return m;
+        }
+
+        Mat2 Inverse(const Mat2& m) {
+            const float det = m.xx * m.yy - m.xy * m.yx;
+            if (std::abs(det) < 1e-20f) return Identity(1.0f);
+
+            const float inv = 1.0f / det;
+            Mat2 r;
+            r.xx = m.yy * inv;  r.xy = -m.xy * inv;
+            r.yx = -m.yx * inv; r.yy = m.xx * inv;
+            return r;
+        }
+
+        template<typename F>
+        void ForEachChunk(size_t rows, F&& fn) {
+            PooledFor(0, rows, [&](size_t begin, size_t end) {
+                fn(begin / RowChunk, begin, end);
+            }, RowChunk);
+        }
+
+    }
+
+    void ClothImplicitSolver::buildPattern(const Cloth& cloth) {
+        const size_t n = cloth.particles.size();
+        const auto& constraints = cloth.constraints;
+
+        std::vector<std::vector<uint32_t>> neighbors(n);
+        for (const auto& constraint : constraints) {
+            neighbors[constraint.first].push_back(constraint.second);
+            neighbors[constraint.second].push_back(constraint.first);
+        }
+
+        matrix.rowStart.assign(n + 1, 0);
+        matrix.columns.clear();
+        diagonal.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            std::vector<uint32_t>& row = neighbors[i];
+            row.push_back(static_cast<uint32_t>(i));
+            std::sort(row.begin(), row.end());
+            row.erase(std::unique(row.begin(), row.end()), row.end());
+
+            diagonal[i] = static_cast<uint32_t>(matrix.columns.size() + (std::find(row.begin(), row.end(), i) - row.begin()));
+            matrix.columns.insert(matrix.columns.end(), row.begin(), row.end());
+            matrix.rowStart[i + 1] = static_cast<uint32_t>(matrix.columns.size());
+        }
+        matrix.blocks.assign(matrix.columns.size(), Mat2());
+
+        auto blockOf = [&](uint32_t row, uint32_t column) {
+            const auto first = matrix.columns.begin() + matrix.rowStart[row];
+            const auto last = matrix.columns.begin() + matrix.rowStart[row + 1];
+            return static_cast<uint32_t>(std::lower_bound(first, last, column) - matrix.columns.begin());
+        };
+
+        // Per particle, the constraints touching it and where their coupling block lives.
+        incidenceStart.assign(n + 1, 0);
+        for (const auto& constraint : constraints) {
+            incidenceStart[constraint.first + 1]++;
+            incidenceStart[constraint.second + 1]++;
+        }
+        std::partial_sum(incidenceStart.begin(), incidenceStart.end(), incidenceStart.begin());
+
+        incidence.resize(incidenceStart[n]);
+        std::vector<uint32_t> cursor(incidenceStart.begin(), incidenceStart.end() - 1);
+        for (size_t c = 0; c < constraints.size(); ++c) {
+            const uint32_t a = constraints[c].first, b = constraints[c].second;
+            incidence[cursor[a]++] = { static_cast<uint32_t>(c), blockOf(a, b), true };
+            incidence[cursor[b]++] = { static_cast<uint32_t>(c), blockOf(b, a), false };
+        }
+
+        patternParticles = n;
+        patternConstraints = constraints;
+    }
+
+    void ClothImplicitSolver::assemble(const Cloth& cloth, float h) {
+        const size_t n = cloth.particles.size();
+        const auto& particles = cloth.particles;
+        const auto& constraints = cloth.constraints;
+
+        fixed.resize(n);
+        velocity.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            const Particle& particle = particles[i];
+            fixed[i] = particle.isStatic || cloth.islands[cloth.islandOf[i]].sleeping;
+            // Velocity is carried by the Verlet pair, so the two integrators can be switched freely.
+            velocity[i] = fixed[i] ? Vec2() : (particle.position - particle.oldPosition) * (1.0f / h);
+        }
+
+        springs.resize(constraints.size());
+        PooledFor(0, constraints.size(), [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                const int a = constraints[c].first, b = constraints[c].second;
+                const Vec2 d = particles[a].position - particles[b].position;
+                const float length = d.length();
+                const Vec2 dir = length > 1e-9f ? d * (1.0f / length) : Vec2(1.0f, 0.0f);
+                const Vec2 relative = velocity[a] - velocity[b];
+
+                const Vec2 force = dir * (-cloth.stiffness * (length - cloth.restLength) - cloth.damping * dot(relative, dir));
+
+                // dF/dx = -k (n n^T + (1 - L / l) (I - n n^T)); the transverse term is
+                // dropped under compression, where it would make the system indefinite.
+                const float transverse = length > cloth.restLength ? 1.0f - cloth.restLength / length : 0.0f;
+                const float nxx = dir.x * dir.x, nxy = dir.x * dir.y, nyy = dir.y * dir.y;
+
+                Mat2 jx;
+                jx.xx = -cloth.stiffness * (nxx + transverse * (1.0f - nxx));
+                jx.xy = jx.yx = -cloth.stiffness * (nxy - transverse * nxy);
+                jx.yy = -cloth.stiffness * (nyy + transverse * (1.0f - nyy));
+
+                // dF/dv = -c n n^T
+                SpringTerms& spring = springs[c];
+                spring.impulse = (force + (jx * relative) * h) * h;
+                spring.stiffness.xx = -(h * h * jx.xx - h * cloth.damping * nxx);
+                spring.stiffness.xy = -(h * h * jx.xy - h * cloth.damping * nxy);
+                spring.stiffness.yx = spring.stiffness.xy;
+                spring.stiffness.yy = -(h * h * jx.yy - h * cloth.damping * nyy);
+            }
+        }, RowChunk);
+
+        rhs.resize(n);
+        preconditioner.resize(n);
+        PooledFor(0, n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                for (uint32_t k = matrix.rowStart[i]; k < matrix.rowStart[i + 1]; ++k)
+                    matrix.blocks[k] = Mat2();
+
+                Mat2& diag = matrix.blocks[diagonal[i]];
+                if (fixed[i]) {
+                    diag = Identity(1.0f);
+                    rhs[i] = Vec2();
+                    preconditioner[i] = diag;
+                    continue;
+                }
+
+                diag = Identity(cloth.particleMass);
+                rhs[i] = particles[i].acceleration * (cloth.particleMass * h);
+
+                for (uint32_t k = incidenceStart[i]; k < incidenceStart[i + 1]; ++k) {
+                    const Incidence& in = incidence[k];
+                    const SpringTerms& spring = springs[in.constraint];
+                    const auto& constraint = constraints[in.constraint];
+                    const int other = in.first ? constraint.second : constraint.first;
+
+                    diag += spring.stiffness;
+                    if (!fixed[other]) matrix.blocks[in.block] -= spring.stiffness;
+                    rhs[i] += in.first ? spring.impulse : spring.impulse * -1.0f;
+                }
+
+                preconditioner[i] = Inverse(diag);
+            }
+        }, RowChunk);
+    }
+
+    bool ClothImplicitSolver::solve(const Cloth& cloth) {
+        const size_t n = matrix.rows();
+        const size_t chunks = (n + RowChunk - 1) / RowChunk;
+        partial.resize(2 * chunks);
+
+        auto sum = [&](size_t offset) {
+            double total = 0.0;
+            for (size_t c = 0; c < chunks; ++c) total += partial[offset + c];
+            return total;
+        };
+
+        dv.assign(n, Vec2());
+        r = rhs;
+        z.resize(n);
+        p.resize(n);
+        Ap.resize(n);
+
+        ForEachChunk(n, [&](size_t chunk, size_t begin, size_t end) {
+            double rz = 0.0, bb = 0.0;
+            for (size_t i = begin; i < end; ++i) {
+                z[i] = preconditioner[i] * r[i];
+                p[i] = z[i];
+                rz += dot(r[i], z[i]);
+                bb += dot(r[i], r[i]);
+            }
+            partial[chunk] = rz;
+            partial[chunks + chunk] = bb;
+        });
+
+        double rz = sum(0);
+        const double bb = sum(chunks);
+        const double tolerance = static_cast<double>(cloth.solverTolerance) * cloth.solverTolerance * bb;
+
+        iterations = 0;
+        residual = 0.0f;
+        if (bb == 0.0) return true;
+
+        double rr = bb;
+        while (iterations < cloth.solverIterations) {
+            ++iterations;
+
+            ForEachChunk(n, [&](size_t chunk, size_t begin, size_t end) {
+                double pAp = 0.0;
+                for (size_t i = begin; i < end; ++i) {
+                    Vec2 product;
+                    for (uint32_t k = matrix.rowStart[i]; k < matrix.rowStart[i + 1]; ++k)
+                        product += matrix.blocks[k] * p[matrix.columns[k]];
+                    Ap[i] = product;
+                    pAp += dot(p[i], product);
+                }
+                partial[chunk] = pAp;
+            });
+
+            const double pAp = sum(0);
+            if (pAp <= 0.0) break;
+            const float alpha = static_cast<float>(rz / pAp);
+
+            ForEachChunk(n, [&](size_t chunk, size_t begin, size_t end) {
+                double rzNext = 0.0, rrNext = 0.0;
+                for (size_t i = begin; i < end; ++i) {
+                    dv[i] += p[i] * alpha;
+                    r[i] -= Ap[i] * alpha;
+                    z[i] = preconditioner[i] * r[i];
+                    rzNext += dot(r[i], z[i]);
+                    rrNext += dot(r[i], r[i]);
+                }
+                partial[chunk] = rzNext;
+                partial[chunks + chunk] = rrNext;
+            });
+
+            const double rzNext = sum(0);
+            rr = sum(chunks);
+            if (rr <= tolerance) break;
+
+            const float beta = static_cast<float>(rzNext / rz);
+            rz = rzNext;
+
+            PooledFor(0, n, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                    p[i] = z[i] + p[i] * beta;
+            }, RowChunk);
+        }
+
+        residual = static_cast<float>(std::sqrt(rr / bb));
+        return rr <= tolerance;
+    }
+
+    bool ClothImplicitSolver::step(Cloth& cloth, float ts) {
+        if (cloth.particles.size() != patternParticles || cloth.constraints != patternConstraints)
+            buildPattern(cloth);
+
+        assemble(cloth, ts);
+        const bool converged = solve(cloth);
+
+        auto& particles = cloth.particles;
+        PooledFor(0, particles.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (fixed[i]) continue;
+
+                Particle& particle = particles[i];
+                const Vec2 v = velocity[i] + dv[i];
+                particle.oldPosition = particle.position;
+                particle.position += v * ts;
+                particle.acceleration = { 0, 0 };
+            }
+        }, RowChunk);
+
+        return converged;
+    }
+
+} // namespace QP
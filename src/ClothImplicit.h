@@ -0,0 +1,89 @@
+/// Backward Euler cloth integration in the style of Baraff & Witkin.
+///
+/// Every constraint is a damped spring. One step solves
+///
+///     (M - h dF/dv - h^2 dF/dx) dv = h (F + h dF/dx v)
+///
+/// for the velocity change dv, with analytic spring Jacobians, then sets
+/// v += dv and x += h v. The matrix is stored as 2x2 blocks in CSR form; its
+/// sparsity pattern follows the constraints and is built once, so each step
+/// only refills the blocks. The system is solved with conjugate gradients,
+/// preconditioned by the inverse diagonal blocks, with SpMV and vector updates
+/// parallel over rows on the shared WorkerPool.
+///
+/// Static particles and particles in sleeping islands are held fixed by
+/// replacing their rows and columns with the identity.
+
+#pragma once
+
+#include "Vector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace QP {
+
+    class Cloth;
+
+    /// Row-major 2x2 block.
+    struct Mat2 {
+        float xx{0.0f}, xy{0.0f};
+        float yx{0.0f}, yy{0.0f};
+    };
+
+    /// Sparse matrix of 2x2 blocks in CSR layout.
+    struct BlockMatrix {
+        std::vector<uint32_t> rowStart;     ///< rows() + 1 offsets into columns / blocks
+        std::vector<uint32_t> columns;
+        std::vector<Mat2> blocks;
+
+        size_t rows() const { return rowStart.empty() ? 0 : rowStart.size() - 1; }
+    };
+
+    class ClothImplicitSolver {
+    public:
+        /// Advances the awake particles of cloth by ts. Returns false if the
+        /// solve stopped at cloth.solverIterations before reaching the tolerance;
+        /// the step is applied either way.
+        bool step(Cloth& cloth, float ts);
+
+        int iterations{0};          ///< CG iterations used by the last step
+        float residual{0.0f};       ///< relative residual after the last step
+
+    private:
+        /// A constraint as seen from one of its particles.
+        struct Incidence {
+            uint32_t constraint;
+            uint32_t block;         ///< off-diagonal block in this particle's row
+            bool first;             ///< particle is constraints[constraint].first
+        };
+
+        struct SpringTerms {
+            Vec2 impulse;           ///< h (F + h dF/dx v) on the first particle; the second gets -impulse
+            Mat2 stiffness;         ///< -(h^2 dF/dx + h dF/dv), shared by all four blocks
+        };
+
+        void buildPattern(const Cloth& cloth);
+        void assemble(const Cloth& cloth, float ts);
+        bool solve(const Cloth& cloth);
+
+        /// Topology the pattern was built for; any edit to it, including an
+        /// in-place one or a restore with equal counts, triggers a rebuild.
+        size_t patternParticles{0};
+        std::vector<std::pair<int, int>> patternConstraints;
+
+        BlockMatrix matrix;
+        std::vector<uint32_t> diagonal;         ///< block index of (i, i)
+        std::vector<uint32_t> incidenceStart;
+        std::vector<Incidence> incidence;
+
+        std::vector<uint8_t> fixed;
+        std::vector<SpringTerms> springs;
+        std::vector<Vec2> velocity, rhs, dv, r, z, p, Ap;
+        std::vector<Mat2> preconditioner;
+        std::vector<double> partial;
+    };
+
+} // namespace QP
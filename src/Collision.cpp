@@ -0,0 +1,301 @@
+#include "Collision.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace QP {
+
+    namespace {
+
+        /// Bodies added between steps beyond which broadphase does a full sort.
+        constexpr size_t UnsortedSortThreshold = 16;
+
+    }
+
+    CollisionWorld::CollisionWorld(const Vec2& gravity)
+        : gravity(gravity), cachePool(48, 1024),
+          cache(0, std::hash<uint64_t>(), std::equal_to<uint64_t>(),
+              PoolAllocator<std::pair<const uint64_t, CachedImpulse>>(cachePool)) {
+    }
+
+    uint32_t CollisionWorld::addBody(const Vec2& position, float radius, float mass, const Vec2& velocity,
+        float restitution, float friction) {
+        uint32_t index = static_cast<uint32_t>(bodies.size());
+        bodies.push_back({ position, velocity, radius, mass > 0.0f ? 1.0f / mass : 0.0f, restitution, friction });
+
+        // New bodies go to the end; the next broadphase sorts them into place.
+        order.push_back(index);
+        unsortedBodies++;
+        return index;
+    }
+
+    void CollisionWorld::setBounds(const Vec2& min, const Vec2& max) {
+        bounded = true;
+        boundsMin = min;
+        boundsMax = max;
+    }
+
+    void CollisionWorld::step(float dt) {
+        if (dt <= 0.0f) return;
+
+        for (auto& body : bodies) {
+            if (body.invMass > 0.0f) body.velocity += gravity * dt;
+        }
+
+        broadphase();
+        narrowphase();
+        solve();
+
+        cache.clear();
+        for (const Contact& contact : contacts) {
+            cache[PairKey(contact.a, contact.b)] = { contact.normalImpulse, contact.tangentImpulse };
+        }
+
+        for (auto& body : bodies) {
+            if (body.invMass > 0.0f) body.position += body.velocity * dt;
+        }
+
+        solvePositions();
+        if (bounded) applyBounds();
+    }
+
+    void CollisionWorld::broadphase() {
+        const size_t n = bodies.size();
+        minX.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            minX[i] = bodies[i].position.x - bodies[i].radius;
+        }
+
+        // Insertion sort on the previous order: O(n + swaps), and swaps are few
+        // when bodies move a fraction of their size per step. Each appended body
+        // may travel the whole array, so after a batch of additions one full sort
+        // is cheaper.
+        size_t swaps = 0;
+        if (unsortedBodies > UnsortedSortThreshold) {
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                return minX[a] < minX[b] || (minX[a] == minX[b] && a < b);
+            });
+        }
+        unsortedBodies = 0;
+        for (size_t i = 1; i < n; ++i) {
+            uint32_t body = order[i];
+            float key = minX[body];
+            size_t j = i;
+            while (j > 0 && minX[order[j - 1]] > key) {
+                order[j] = order[j - 1];
+                --j;
+                ++swaps;
+            }
+            order[j] = body;
+        }
+        counters.sortSwaps = swaps;
+
+        pairs.clear();
+        for (size_t i = 0; i < n; ++i) {
+            const CollisionBody& a = bodies[order[i]];
+            const float maxX = a.position.x + a.radius;
+
+            for (size_t j = i + 1; j < n && minX[order[j]] <= maxX; ++j) {
+                const CollisionBody& b = bodies[order[j]];
+                if (a.invMass == 0.0f && b.invMass == 0.0f) continue;
+                if (std::abs(a.position.y - b.position.y) > a.radius + b.radius) continue;
+
+                uint32_t ia = order[i], ib = order[j];
+                pairs.emplace_back(std::min(ia, ib), std::max(ia, ib));
+            }
+        }
+        counters.broadphasePairs = pairs.size();
+    }
+
+    void CollisionWorld::narrowphase() {
+        const size_t m = pairs.size();
+        dx.resize(m);
+        dy.resize(m);
+        radiusSum.resize(m);
+        overlap.resize(m);
+        hits.resize(m);
+
+        for (size_t k = 0; k < m; ++k) {
+            const CollisionBody& a = bodies[pairs[k].first];
+            const CollisionBody& b = bodies[pairs[k].second];
+            dx[k] = b.position.x - a.position.x;
+            dy[k] = b.position.y - a.position.y;
+            radiusSum[k] = a.radius + b.radius;
+        }
+
+        // Overlap mask for every pair: squared distances only, no sqrt (which may
+        // set errno and stops vectorization), over contiguous arrays.
+        const float* pdx = dx.data();
+        const float* pdy = dy.data();
+        const float* pr = radiusSum.data();
+        uint8_t* pmask = overlap.data();
+        for (size_t k = 0; k < m; ++k) {
+            const float d2 = pdx[k] * pdx[k] + pdy[k] * pdy[k];
+            pmask[k] = d2 < pr[k] * pr[k];
+        }
+
+        // Compact the hits: every index is written, the cursor only advances on overlap.
+        size_t hitCount = 0;
+        for (size_t k = 0; k < m; ++k) {
+            hits[hitCount] = static_cast<uint32_t>(k);
+            hitCount += pmask[k];
+        }
+
+        contacts.clear();
+        counters.warmStarted = 0;
+
+        // Distance, normal and penetration only for the overlapping pairs.
+        for (size_t h = 0; h < hitCount; ++h) {
+            const uint32_t k = hits[h];
+            const float d = std::sqrt(dx[k] * dx[k] + dy[k] * dy[k]);
+            const Vec2 normal = d > 1e-6f ? Vec2(dx[k] / d, dy[k] / d) : Vec2(0.0f, 1.0f);
+            addContact(pairs[k].first, pairs[k].second, normal, radiusSum[k] - d);
+        }
+
+        if (bounded) {
+            for (uint32_t i = 0; i < bodies.size(); ++i) {
+                const CollisionBody& b = bodies[i];
+                if (b.invMass == 0.0f) continue;
+
+                const float left = b.position.x - b.radius - boundsMin.x;
+                const float right = boundsMax.x - (b.position.x + b.radius);
+                const float bottom = b.position.y - b.radius - boundsMin.y;
+                const float top = boundsMax.y - (b.position.y + b.radius);
+
+                if (left < 0.0f) addContact(CollisionWallBase + 0, i, Vec2(1.0f, 0.0f), -left);
+                if (right < 0.0f) addContact(CollisionWallBase + 1, i, Vec2(-1.0f, 0.0f), -right);
+                if (bottom < 0.0f) addContact(CollisionWallBase + 2, i, Vec2(0.0f, 1.0f), -bottom);
+                if (top < 0.0f) addContact(CollisionWallBase + 3, i, Vec2(0.0f, -1.0f), -top);
+            }
+        }
+
+        counters.contacts = contacts.size();
+    }
+
+    void CollisionWorld::addContact(uint32_t ia, uint32_t ib, const Vec2& normal, float penetration) {
+        CollisionBody& a = body(ia);
+        CollisionBody& b = body(ib);
+
+        Contact contact;
+        contact.a = ia;
+        contact.b = ib;
+        contact.normal = normal;
+        contact.penetration = penetration;
+        contact.normalMass = 1.0f / (a.invMass + b.invMass);
+        contact.normalImpulse = 0.0f;
+        contact.tangentImpulse = 0.0f;
+
+        // Only fresh impacts bounce; a persistent contact deep in a pile re-applying
+        // restitution every step pumps energy into the stack. Overlap is removed by
+        // solvePositions, so it never turns into velocity either.
+        contact.bias = 0.0f;
+
+        auto cached = cache.find(PairKey(ia, ib));
+        if (cached == cache.end()) {
+            const float vn = dot(b.velocity - a.velocity, normal);
+            const float e = std::max(a.restitution, b.restitution);
+            if (vn < -1.0f) contact.bias = -e * vn;
+        } else {
+            contact.normalImpulse = cached->second.normal;
+            contact.tangentImpulse = cached->second.tangent;
+
+            const Vec2 tangent(-normal.y, normal.x);
+            const Vec2 impulse = normal * contact.normalImpulse + tangent * contact.tangentImpulse;
+            a.velocity -= impulse * a.invMass;
+            b.velocity += impulse * b.invMass;
+            counters.warmStarted++;
+        }
+
+        contacts.push_back(contact);
+    }
+
+    void CollisionWorld::solve() {
+        for (int iteration = 0; iteration < iterations; ++iteration) {
+            for (Contact& contact : contacts) {
+                CollisionBody& a = body(contact.a);
+                CollisionBody& b = body(contact.b);
+                const Vec2 tangent(-contact.normal.y, contact.normal.x);
+
+                // Friction, clamped by the current normal impulse.
+                const float vt = dot(b.velocity - a.velocity, tangent);
+                const float mu = std::sqrt(a.friction * b.friction);
+                const float maxFriction = mu * contact.normalImpulse;
+                float lambda = -vt * contact.normalMass;
+                float total = std::max(-maxFriction, std::min(contact.tangentImpulse + lambda, maxFriction));
+                lambda = total - contact.tangentImpulse;
+                contact.tangentImpulse = total;
+
+                a.velocity -= tangent * (lambda * a.invMass);
+                b.velocity += tangent * (lambda * b.invMass);
+
+                // Non-penetration, accumulated impulse kept non-negative.
+                const float vn = dot(b.velocity - a.velocity, contact.normal);
+                lambda = (contact.bias - vn) * contact.normalMass;
+                total = std::max(contact.normalImpulse + lambda, 0.0f);
+                lambda = total - contact.normalImpulse;
+                contact.normalImpulse = total;
+
+                a.velocity -= contact.normal * (lambda * a.invMass);
+                b.velocity += contact.normal * (lambda * b.invMass);
+            }
+        }
+    }
+
+    float CollisionWorld::separation(const Contact& contact, Vec2& normal) const {
+        const CollisionBody& b = bodies[contact.b];
+
+        if (contact.a >= CollisionWallBase) {
+            normal = contact.normal;
+            switch (contact.a - CollisionWallBase) {
+            case 0: return b.position.x - b.radius - boundsMin.x;
+            case 1: return boundsMax.x - (b.position.x + b.radius);
+            case 2: return b.position.y - b.radius - boundsMin.y;
+            default: return boundsMax.y - (b.position.y + b.radius);
+            }
+        }
+
+        const CollisionBody& a = bodies[contact.a];
+        const Vec2 d = b.position - a.position;
+        const float dist = d.length();
+        normal = dist > 1e-6f ? d * (1.0f / dist) : contact.normal;
+        return dist - a.radius - b.radius;
+    }
+
+    void CollisionWorld::solvePositions() {
+        // Nonlinear Gauss-Seidel on the integrated positions, with each
+        // correction capped so deep overlaps resolve over a few steps.
+        for (int iteration = 0; iteration < positionIterations; ++iteration) {
+            for (const Contact& contact : contacts) {
+                CollisionBody& a = body(contact.a);
+                CollisionBody& b = body(contact.b);
+
+                Vec2 normal;
+                const float C = std::min(baumgarte * std::max(-separation(contact, normal) - slop, 0.0f), maxCorrection);
+                if (C <= 0.0f) continue;
+
+                const Vec2 correction = normal * (C * contact.normalMass);
+                a.position -= correction * a.invMass;
+                b.position += correction * b.invMass;
+            }
+        }
+    }
+
+    void CollisionWorld::applyBounds() {
+        // Walls are solved as contacts. This only rescues bodies fast enough to
+        // tunnel past a wall's centre line; clamping resting bodies here would
+        // break their wall contact every step.
+        for (auto& b : bodies) {
+            if (b.invMass == 0.0f) continue;
+
+            if (b.position.x < boundsMin.x || b.position.x > boundsMax.x) {
+                b.position.x = std::max(boundsMin.x + b.radius, std::min(b.position.x, boundsMax.x - b.radius));
+                b.velocity.x = 0.0f;
+            }
+            if (b.position.y < boundsMin.y || b.position.y > boundsMax.y) {
+                b.position.y = std::max(boundsMin.y + b.radius, std::min(b.position.y, boundsMax.y - b.radius));
+                b.velocity.y = 0.0f;
+            }
+        }
+    }
+
+} // namespace QP
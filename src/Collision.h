@@ -0,0 +1,119 @@
+/// Rigid circle collision simulation.
+///
+/// Each step runs an incremental sweep-and-prune broadphase along x (the body
+/// order from the previous step is kept and re-sorted with insertion sort, which
+/// is near-linear when bodies move little; a batch of new bodies triggers one
+/// full sort instead), a structure-of-arrays narrowphase with a vectorizable
+/// overlap test,
+/// and a sequential-impulse contact solver warm-started from the previous
+/// step's impulses. Overlap is corrected on positions afterwards, so it never
+/// feeds energy back into velocities.
+
+#pragma once
+
+#include "Arena.h"
+#include "Vector.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace QP {
+
+    struct CollisionBody {
+        Vec2 position;
+        Vec2 velocity;
+        float radius;
+        float invMass;      ///< 0 for static bodies
+        float restitution;
+        float friction;
+    };
+
+    /// Contacts against the bounds use a = CollisionWallBase + wall (0..3).
+    constexpr uint32_t CollisionWallBase = 0xFFFFFFF0u;
+
+    struct Contact {
+        uint32_t a, b;
+        Vec2 normal;        ///< from a to b
+        float penetration;
+        float normalMass;
+        float bias;         ///< target separating speed from restitution
+        float normalImpulse;
+        float tangentImpulse;
+    };
+
+    struct CollisionStats {
+        size_t broadphasePairs{0};
+        size_t contacts{0};
+        size_t warmStarted{0};
+        size_t sortSwaps{0};
+    };
+
+    class CollisionWorld {
+    public:
+        explicit CollisionWorld(const Vec2& gravity = Vec2(0.0f, -9.81f));
+
+        /// A mass of 0 makes the body static. Returns the body index.
+        uint32_t addBody(const Vec2& position, float radius, float mass, const Vec2& velocity = Vec2(),
+            float restitution = 0.2f, float friction = 0.3f);
+
+        /// Keeps all bodies inside an axis-aligned box; the walls take part in the contact solve.
+        void setBounds(const Vec2& min, const Vec2& max);
+
+        void step(float dt);
+
+        const CollisionStats& stats() const { return counters; }
+        const std::vector<Contact>& getContacts() const { return contacts; }
+
+    public:
+        std::vector<CollisionBody> bodies;
+        Vec2 gravity;
+        int iterations{8};
+        int positionIterations{3};
+        float baumgarte{0.2f};      ///< fraction of overlap removed per position iteration
+        float slop{0.005f};
+        float maxCorrection{0.2f};
+
+    private:
+        struct CachedImpulse {
+            float normal;
+            float tangent;
+        };
+
+        using ImpulseCache = std::unordered_map<uint64_t, CachedImpulse, std::hash<uint64_t>, std::equal_to<uint64_t>,
+            PoolAllocator<std::pair<const uint64_t, CachedImpulse>>>;
+
+        static uint64_t PairKey(uint32_t a, uint32_t b) { return (static_cast<uint64_t>(a) << 32) | b; }
+
+        CollisionBody& body(uint32_t index) { return index >= CollisionWallBase ? wall : bodies[index]; }
+
+        void broadphase();
+        void narrowphase();
+        void addContact(uint32_t a, uint32_t b, const Vec2& normal, float penetration);
+        void solve();
+        float separation(const Contact& contact, Vec2& normal) const;
+        void solvePositions();
+        void applyBounds();
+
+        std::vector<uint32_t> order;
+        size_t unsortedBodies{0};   ///< appended to order since the last broadphase
+        std::vector<float> minX;
+        std::vector<std::pair<uint32_t, uint32_t>> pairs;
+
+        // Narrowphase scratch, one entry per broadphase pair.
+        std::vector<float> dx, dy, radiusSum;
+        std::vector<uint8_t> overlap;
+        std::vector<uint32_t> hits;     ///< compacted indices of overlapping pairs
+
+        std::vector<Contact> contacts;
+        BlockPool cachePool;
+        ImpulseCache cache;
+
+        bool bounded{false};
+        Vec2 boundsMin, boundsMax;
+        CollisionBody wall{ Vec2(), Vec2(), 0.0f, 0.0f, 0.2f, 0.3f };
+
+        CollisionStats counters;
+    };
+
+} // namespace QP
@@ -0,0 +1,435 @@
+#include "DistributedFluid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace QP {
+
+    namespace {
+
+        constexpr uint32_t TagAdvectHalo = 1;
+        constexpr uint32_t TagDiffuseHalo = 2;
+        constexpr uint32_t TagPressureFromLeft = 3;
+        constexpr uint32_t TagPressureFromRight = 4;
+        constexpr uint32_t TagScatter = 5;
+        constexpr uint32_t TagGather = 6;
+
+        constexpr float DiffusionRate = 0.1f; // same coefficient as FluidSimulation::update
+        constexpr int PressureIterations = 20;
+
+    }
+
+    DistributedFluid::DistributedFluid(Transport& transport, int width, int height)
+        : width(width), height(height), transport(transport),
+          rank(transport.rank()), ranks(transport.size()) {
+        x0 = slabBegin(rank);
+        x1 = slabEnd(rank);
+        reserveHalo(1);
+        addObstacle(DefaultFluidObstacle());
+    }
+
+    int DistributedFluid::slabBegin(int r) const {
+        return static_cast<int>(static_cast<int64_t>(width) * r / ranks);
+    }
+
+    void DistributedFluid::reserveHalo(int columns) {
+        if (columns <= halo) return;
+
+        const int owned = x1 - x0;
+        const size_t cells = static_cast<size_t>(owned + 2 * columns) * height;
+        const size_t shift = static_cast<size_t>(columns - halo) * height;
+        const size_t slab = static_cast<size_t>(owned) * height;
+        const size_t from = static_cast<size_t>(halo) * height;
+
+        // Move the owned columns to their new offset; ghost columns are refilled every step.
+        auto grow = [&](auto& field) {
+            std::remove_reference_t<decltype(field)> next(cells, 0);
+            if (!field.empty())
+                std::copy(field.begin() + from, field.begin() + from + slab, next.begin() + from + shift);
+            field.swap(next);
+        };
+
+        grow(smoke);
+        grow(u);
+        grow(v);
+        grow(obstacle);
+        for (auto* scratch : { &smokeNext, &uNext, &vNext, &div, &p })
+            scratch->assign(cells, 0.0f);
+
+        halo = columns;
+    }
+
+    void DistributedFluid::markObstacle(int x, int y, bool solid) {
+        uint8_t& cell = obstacle[index(x, y)];
+        if (cell == static_cast<uint8_t>(solid)) return;
+        cell = solid;
+        obstaclesDirty = true;
+    }
+
+    void DistributedFluid::setObstacle(int x, int y, bool solid) {
+        if (owns(x, y)) markObstacle(x, y, solid);
+    }
+
+    void DistributedFluid::addObstacle(const ObstacleShape& shape) {
+        for (int x = x0; x < x1; ++x)
+            for (int y = 0; y < height; ++y)
+                if (shape(static_cast<float>(x), static_cast<float>(y)) <= 0.0f) markObstacle(x, y, true);
+    }
+
+    void DistributedFluid::removeObstacle(const ObstacleShape& shape) {
+        for (int x = x0; x < x1; ++x)
+            for (int y = 0; y < height; ++y)
+                if (shape(static_cast<float>(x), static_cast<float>(y)) <= 0.0f) markObstacle(x, y, false);
+    }
+
+    void DistributedFluid::clearObstacles() {
+        for (int x = x0; x < x1; ++x)
+            for (int y = 0; y < height; ++y)
+                markObstacle(x, y, false);
+    }
+
+    void DistributedFluid::setObstacles(const ObstacleBitmap& bitmap) {
+        if (bitmap.width <= 0 || bitmap.height <= 0) return;
+
+        // Same nearest-cell scaling as FluidSimulation::setObstacles.
+        for (int x = x0; x < x1; ++x) {
+            const size_t bx = static_cast<size_t>(x) * bitmap.width / width;
+            for (int y = 0; y < height; ++y) {
+                const size_t by = static_cast<size_t>(y) * bitmap.height / height;
+                markObstacle(x, y, bitmap.solid[by * bitmap.width + bx] != 0);
+            }
+        }
+    }
+
+    void DistributedFluid::compileObstacles() {
+        if (!obstaclesDirty) return;
+
+        fluidRuns.resize(static_cast<size_t>(x1 - x0));
+        for (int x = x0; x < x1; ++x) {
+            std::vector<FluidRun>& runs = fluidRuns[x - x0];
+            if (x < 1 || x >= width - 1) {
+                runs.clear();
+                continue;
+            }
+            const uint8_t* column = &obstacle[index(x, 0)];
+            CompileFluidRuns(height, [&](int y) { return column[y] != 0; }, runs);
+        }
+        obstaclesDirty = false;
+    }
+
+    void DistributedFluid::addSmoke(int x, int y, float amount) {
+        if (owns(x, y)) smoke[index(x, y)] += amount;
+    }
+
+    void DistributedFluid::addVelocity(int x, int y, float du, float dv) {
+        if (!owns(x, y)) return;
+        u[index(x, y)] += du;
+        v[index(x, y)] += dv;
+    }
+
+    void DistributedFluid::postHalo(int columns, uint32_t tag) {
+        for (int peer = 0; peer < ranks; ++peer) {
+            if (peer == rank) continue;
+
+            const int begin = std::max(x0, slabBegin(peer) - columns);
+            const int end = std::min(x1, slabEnd(peer) + columns);
+            if (begin >= end) continue;
+
+            const size_t count = static_cast<size_t>(end - begin) * height;
+            buffer.resize(3 * count);
+            std::copy_n(&smoke[index(begin, 0)], count, buffer.begin());
+            std::copy_n(&u[index(begin, 0)], count, buffer.begin() + count);
+            std::copy_n(&v[index(begin, 0)], count, buffer.begin() + 2 * count);
+            transport.send(peer, tag, buffer.data(), buffer.size() * sizeof(float));
+        }
+    }
+
+    bool DistributedFluid::completeHalo(int columns, uint32_t tag) {
+        bool ok = true;
+        for (int peer = 0; peer < ranks; ++peer) {
+            if (peer == rank) continue;
+
+            const int begin = std::max(slabBegin(peer), x0 - columns);
+            const int end = std::min(slabEnd(peer), x1 + columns);
+            if (begin >= end) continue;
+
+            const size_t count = static_cast<size_t>(end - begin) * height;
+            buffer.resize(3 * count);
+            if (!transport.recv(peer, tag, buffer.data(), buffer.size() * sizeof(float))) {
+                ok = false;
+                continue;
+            }
+            std::copy_n(buffer.begin(), count, &smoke[index(begin, 0)]);
+            std::copy_n(buffer.begin() + count, count, &u[index(begin, 0)]);
+            std::copy_n(buffer.begin() + 2 * count, count, &v[index(begin, 0)]);
+        }
+        return ok;
+    }
+
+    void DistributedFluid::advectColumns(int begin, int end, float dt) {
+        begin = std::max(begin, 1);
+        end = std::min(end, width - 1);
+
+        // Same arithmetic, in the same order, as FluidSimulation::advect.
+        for (int x = begin; x < end; ++x) {
+            for (const FluidRun& run : runs(x)) {
+                for (int y = run.begin; y < run.end; ++y) {
+                    const size_t i = index(x, y);
+
+                    float bx = x - u[i] * dt;
+                    float by = y - v[i] * dt;
+
+                    bx = std::max(0.0f, std::min(bx, static_cast<float>(width - 1)));
+                    by = std::max(0.0f, std::min(by, static_cast<float>(height - 1)));
+
+                    const int fx = static_cast<int>(std::floor(bx));
+                    const int fy = static_cast<int>(std::floor(by));
+
+                    const float tx = bx - fx;
+                    const float ty = by - fy;
+
+                    if (fx >= 0 && fx + 1 < width && fy >= 0 && fy + 1 < height) {
+                        const size_t c00 = index(fx, fy), c10 = index(fx + 1, fy);
+                        const size_t c01 = c00 + 1, c11 = c10 + 1;
+
+                        smokeNext[i] = (1 - tx) * (1 - ty) * smoke[c00] + tx * (1 - ty) * smoke[c10] +
+                            (1 - tx) * ty * smoke[c01] + tx * ty * smoke[c11];
+                        uNext[i] = (1 - tx) * (1 - ty) * u[c00] + tx * (1 - ty) * u[c10] +
+                            (1 - tx) * ty * u[c01] + tx * ty * u[c11];
+                        vNext[i] = (1 - tx) * (1 - ty) * v[c00] + tx * (1 - ty) * v[c10] +
+                            (1 - tx) * ty * v[c01] + tx * ty * v[c11];
+                    }
+                }
+            }
+        }
+    }
+
+    bool DistributedFluid::advect(float dt) {
+        // Every rank needs the same halo width, so agree on the largest backtrace.
+        float reach = 0.0f;
+        for (int x = x0; x < x1; ++x)
+            for (int y = 0; y < height; ++y)
+                reach = std::max(reach, std::fabs(u[index(x, y)] * dt));
+        if (!AllReduceMax(transport, reach)) return false;
+
+        // A backtrace of at most k cells reads columns x - k .. x + k + 1.
+        const int columns = reach < width ? static_cast<int>(std::ceil(reach)) + 1 : width;
+        reserveHalo(columns);
+
+        postHalo(columns, TagAdvectHalo);
+
+        const size_t begin = index(x0, 0), end = index(x1, 0);
+        std::copy(smoke.begin() + begin, smoke.begin() + end, smokeNext.begin() + begin);
+        std::copy(u.begin() + begin, u.begin() + end, uNext.begin() + begin);
+        std::copy(v.begin() + begin, v.begin() + end, vNext.begin() + begin);
+
+        // Columns whose backtrace stays inside the slab go first.
+        const int inner0 = std::min(x0 + columns, x1);
+        const int inner1 = std::max(x1 - columns, inner0);
+        advectColumns(inner0, inner1, dt);
+
+        if (!completeHalo(columns, TagAdvectHalo)) return false;
+        advectColumns(x0, inner0, dt);
+        advectColumns(inner1, x1, dt);
+
+        smoke.swap(smokeNext);
+        u.swap(uNext);
+        v.swap(vNext);
+        return true;
+    }
+
+    void DistributedFluid::diffuseColumns(int begin, int end, float diff, float dt) {
+        begin = std::max(begin, 1);
+        end = std::min(end, width - 1);
+
+        // FluidSimulation::diffuse relaxes against the pre-diffusion smoke every
+        // iteration, so one pass gives the same values as its 20.
+        for (int x = begin; x < end; ++x) {
+            for (const FluidRun& run : runs(x)) {
+                for (int y = run.begin; y < run.end; ++y) {
+                    const size_t i = index(x, y);
+
+                    smokeNext[i] = (smoke[i] + diff * dt * (
+                        smoke[i + height] +
+                        smoke[i - height] +
+                        smoke[i + 1] +
+                        smoke[i - 1])) / (1 + 4 * diff * dt);
+                }
+            }
+        }
+    }
+
+    void DistributedFluid::divergenceColumns(int begin, int end) {
+        begin = std::max(begin, 1);
+        end = std::min(end, width - 1);
+
+        for (int x = begin; x < end; ++x) {
+            for (const FluidRun& run : runs(x)) {
+                for (int y = run.begin; y < run.end; ++y) {
+                    const size_t i = index(x, y);
+
+                    div[i] = -0.5f * (u[i + height] - u[i - height] + v[i + 1] - v[i - 1]) / width;
+                }
+            }
+        }
+    }
+
+    bool DistributedFluid::diffuseAndDivergence(float diff, float dt) {
+        postHalo(1, TagDiffuseHalo);
+
+        std::fill(div.begin(), div.end(), 0.0f);
+        smokeNext = smoke;
+
+        const int inner0 = std::min(x0 + 1, x1);
+        const int inner1 = std::max(x1 - 1, inner0);
+        diffuseColumns(inner0, inner1, diff, dt);
+        divergenceColumns(inner0, inner1);
+
+        if (!completeHalo(1, TagDiffuseHalo)) return false;
+        diffuseColumns(x0, inner0, diff, dt);
+        diffuseColumns(inner1, x1, diff, dt);
+        divergenceColumns(x0, inner0);
+        divergenceColumns(inner1, x1);
+
+        smoke.swap(smokeNext);
+        return true;
+    }
+
+    bool DistributedFluid::project() {
+        std::fill(p.begin(), p.end(), 0.0f);
+
+        const int begin = std::max(x0, 1);
+        const int end = std::min(x1, width - 1);
+        const bool hasLeft = rank > 0;
+        const bool hasRight = rank + 1 < ranks;
+        const size_t column = static_cast<size_t>(height);
+        float* leftGhost = &p[index(x0 - 1, 0)];
+        float* rightGhost = &p[index(x1, 0)];
+        const size_t bytes = column * sizeof(float);
+
+        for (int k = 0; k < PressureIterations; ++k) {
+            // Left neighbor's sweep k, right neighbor's sweep k - 1 (zero before the first).
+            if (hasLeft && !transport.recv(rank - 1, TagPressureFromLeft, leftGhost, bytes)) return false;
+            if (hasRight && k > 0 && !transport.recv(rank + 1, TagPressureFromRight, rightGhost, bytes)) return false;
+
+            for (int x = begin; x < end; ++x) {
+                for (const FluidRun& run : runs(x)) {
+                    for (int y = run.begin; y < run.end; ++y) {
+                        const size_t i = index(x, y);
+                        p[i] = (div[i] + p[i + height] + p[i - height] + p[i + 1] + p[i - 1]) / 4.0f;
+                    }
+                }
+            }
+
+            if (hasRight) transport.send(rank + 1, TagPressureFromLeft, &p[index(x1 - 1, 0)], bytes);
+            if (hasLeft) transport.send(rank - 1, TagPressureFromRight, &p[index(x0, 0)], bytes);
+        }
+
+        if (hasRight && !transport.recv(rank + 1, TagPressureFromRight, rightGhost, bytes)) return false;
+
+        for (int x = begin; x < end; ++x) {
+            for (const FluidRun& run : runs(x)) {
+                for (int y = run.begin; y < run.end; ++y) {
+                    const size_t i = index(x, y);
+
+                    u[i] -= 0.5f * width * (p[i + height] - p[i - height]);
+                    v[i] -= 0.5f * height * (p[i + 1] - p[i - 1]);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool DistributedFluid::update(float dt) {
+        compileObstacles();
+        return advect(dt) && diffuseAndDivergence(DiffusionRate, dt) && project();
+    }
+
+    bool DistributedFluid::scatter(const FluidSimulation* source) {
+        const size_t count = static_cast<size_t>(x1 - x0) * height;
+
+        auto unpack = [&](const float* data) {
+            for (size_t i = 0; i < count; ++i) {
+                const size_t j = index(x0, 0) + i;
+                smoke[j] = data[4 * i];
+                u[j] = data[4 * i + 1];
+                v[j] = data[4 * i + 2];
+                obstacle[j] = data[4 * i + 3] != 0.0f;
+            }
+            obstaclesDirty = true;
+        };
+
+        if (rank != 0) {
+            buffer.resize(4 * count);
+            if (!transport.recv(0, TagScatter, buffer.data(), buffer.size() * sizeof(float))) return false;
+            unpack(buffer.data());
+            return true;
+        }
+
+        if (!source || source->width != width || source->height != height) {
+            // Still answer every rank so none of them waits forever; the size mismatch fails their recv.
+            for (int r = 1; r < ranks; ++r)
+                transport.send(r, TagScatter, nullptr, 0);
+            return false;
+        }
+
+        for (int r = ranks - 1; r >= 0; --r) {
+            buffer.clear();
+            for (int x = slabBegin(r); x < slabEnd(r); ++x) {
+                for (const FluidCell& cell : source->grid[x]) {
+                    buffer.push_back(cell.smoke);
+                    buffer.push_back(cell.velocity.u);
+                    buffer.push_back(cell.velocity.v);
+                    buffer.push_back(cell.obstacle ? 1.0f : 0.0f);
+                }
+            }
+            if (r > 0) transport.send(r, TagScatter, buffer.data(), buffer.size() * sizeof(float));
+        }
+        unpack(buffer.data());
+        return true;
+    }
+
+    bool DistributedFluid::gather(FluidSimulation* out) {
+        auto pack = [&](int begin, int end, const float* data, FluidSimulation& grid) {
+            size_t i = 0;
+            for (int x = begin; x < end; ++x) {
+                for (int y = 0; y < height; ++y, ++i) {
+                    FluidCell& cell = grid.grid[x][y];
+                    cell.smoke = data[4 * i];
+                    cell.velocity.u = data[4 * i + 1];
+                    cell.velocity.v = data[4 * i + 2];
+                    cell.obstacle = data[4 * i + 3] != 0.0f;
+                }
+            }
+        };
+
+        const size_t count = static_cast<size_t>(x1 - x0) * height;
+        buffer.resize(4 * count);
+        for (size_t i = 0; i < count; ++i) {
+            const size_t j = index(x0, 0) + i;
+            buffer[4 * i] = smoke[j];
+            buffer[4 * i + 1] = u[j];
+            buffer[4 * i + 2] = v[j];
+            buffer[4 * i + 3] = obstacle[j] ? 1.0f : 0.0f;
+        }
+
+        if (rank != 0) {
+            transport.send(0, TagGather, buffer.data(), buffer.size() * sizeof(float));
+            return true;
+        }
+
+        // Receive from every rank even if out is unusable, so no messages are left queued.
+        bool ok = out && out->width == width && out->height == height;
+        if (ok) pack(x0, x1, buffer.data(), *out);
+        for (int r = 1; r < ranks; ++r) {
+            buffer.resize(4 * static_cast<size_t>(slabEnd(r) - slabBegin(r)) * height);
+            const bool received = transport.recv(r, TagGather, buffer.data(), buffer.size() * sizeof(float));
+            if (ok && received) pack(slabBegin(r), slabEnd(r), buffer.data(), *out);
+            ok &= received;
+        }
+        if (ok) out->invalidateObstacles();
+        return ok;
+    }
+
+} // namespace QP
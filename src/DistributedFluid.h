@@ -0,0 +1,116 @@
+/// FluidSimulation split across ranks of a Transport.
+///
+/// The grid is cut into vertical slabs (ranges of x), one per rank. Each rank
+/// stores its slab plus ghost columns on both sides and runs the same
+/// advect / diffuse / project steps as FluidSimulation::update:
+///
+///  - advection exchanges a halo as wide as the largest backtrace distance,
+///    agreed on by all ranks each step;
+///  - diffusion and the divergence exchange a one-column halo;
+///  - the Gauss-Seidel pressure solve is pipelined as a wavefront: a rank starts
+///    sweep k once its left neighbor has finished sweep k, and uses its right
+///    neighbor's sweep k - 1, exactly the values a single sweep over the whole
+///    grid would see.
+///
+/// Halo sends are posted before the interior cells are computed and only
+/// received for the edge columns, so communication overlaps computation.
+/// Obstacles use FluidSimulation's shapes and run-list compilation; each rank
+/// keeps the mask of its own columns. The result is bit-identical to a
+/// single-process FluidSimulation with the same obstacles.
+
+#pragma once
+
+#include "Fluid.h"
+#include "Transport.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace QP {
+
+    class DistributedFluid {
+    public:
+        /// Collective: every rank of transport constructs one with the same size.
+        /// Starts from the same state as FluidSimulation(width, height).
+        DistributedFluid(Transport& transport, int width, int height);
+
+        /// Global coordinates; ignored by ranks that do not own the cell, so every
+        /// rank may make the same calls.
+        void addSmoke(int x, int y, float amount);
+        void addVelocity(int x, int y, float u, float v);
+
+        /// Same obstacle API as FluidSimulation, in global coordinates; every rank
+        /// makes the same calls and applies the part that falls in its slab.
+        void setObstacle(int x, int y, bool solid);
+        void addObstacle(const ObstacleShape& shape);
+        void removeObstacle(const ObstacleShape& shape);
+        void clearObstacles();
+        void setObstacles(const ObstacleBitmap& bitmap);
+
+        /// Collective. Returns false if a message from a peer was lost; the
+        /// state is then inconsistent across ranks and the group should be torn down.
+        bool update(float dt);
+
+        /// Collective. Rank 0 sends slabs of source (only read on rank 0), the
+        /// other ranks receive theirs.
+        bool scatter(const FluidSimulation* source);
+
+        /// Collective. Rank 0 assembles the full grid into out (only written on rank 0).
+        bool gather(FluidSimulation* out);
+
+        /// Owned columns are [beginColumn(), endColumn()).
+        int beginColumn() const { return x0; }
+        int endColumn() const { return x1; }
+        bool owns(int x, int y) const { return x >= x0 && x < x1 && y >= 0 && y < height; }
+
+        float smokeAt(int x, int y) const { return smoke[index(x, y)]; }
+        Velocity velocityAt(int x, int y) const { return { u[index(x, y)], v[index(x, y)] }; }
+
+    public:
+        int width;
+        int height;
+
+    private:
+        int slabBegin(int rank) const;
+        int slabEnd(int rank) const { return slabBegin(rank + 1); }
+
+        size_t index(int x, int y) const {
+            return static_cast<size_t>(x - x0 + halo) * height + y;
+        }
+
+        /// Grows the ghost region to at least columns on each side.
+        void reserveHalo(int columns);
+
+        void markObstacle(int x, int y, bool solid);
+        void compileObstacles();
+        const std::vector<FluidRun>& runs(int x) const { return fluidRuns[x - x0]; }
+
+        /// Sends smoke, u and v of the owned columns within columns of each peer's slab.
+        void postHalo(int columns, uint32_t tag);
+        bool completeHalo(int columns, uint32_t tag);
+
+        void advectColumns(int begin, int end, float dt);
+        void diffuseColumns(int begin, int end, float diff, float dt);
+        void divergenceColumns(int begin, int end);
+
+        bool advect(float dt);
+        bool diffuseAndDivergence(float diff, float dt);
+        bool project();
+
+        Transport& transport;
+        int rank, ranks;
+        int x0, x1;
+        int halo{0};
+
+        // Slab plus ghost columns, column-major like FluidSimulation::grid.
+        std::vector<float> smoke, u, v;
+        std::vector<uint8_t> obstacle;
+        std::vector<float> smokeNext, uNext, vNext, div, p;
+        std::vector<float> buffer;
+
+        /// Per owned column (x - x0): interior fluid runs, as in FluidSimulation.
+        std::vector<std::vector<FluidRun>> fluidRuns;
+        bool obstaclesDirty{true};
+    };
+
+} // namespace QP
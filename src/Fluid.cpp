@@ -16,104 +16,249 @@ namespace QP {
             }
         }
 
-        for (int x = 20; x < 30; ++x) {
-            for (int y = 20; y < 30; ++y) {
-                grid[x][y].obstacle = true;
+        invalidateObstacles();
+        addObstacle(DefaultFluidObstacle());
+    }
+
+    ObstacleShape DefaultFluidObstacle() {
+        return BoxObstacle(Vec2(20.0f, 20.0f), Vec2(29.0f, 29.0f));
+    }
+
+    void FluidSimulation::markObstacle(int x, int y, bool solid) {
+        if (grid[x][y].obstacle == solid) return;
+        if (dirtyColumns.size() != static_cast<size_t>(width)) invalidateObstacles();
+
+        grid[x][y].obstacle = solid;
+        dirtyColumns[x] = 1;
+        obstaclesDirty = true;
+    }
+
+    void FluidSimulation::setObstacle(int x, int y, bool solid) {
+        if (x >= 0 && x < width && y >= 0 && y < height) {
+            markObstacle(x, y, solid);
+        }
+    }
+
+    void FluidSimulation::addObstacle(const ObstacleShape& shape) {
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < height; ++y) {
+                if (shape(static_cast<float>(x), static_cast<float>(y)) <= 0.0f) markObstacle(x, y, true);
+            }
+        }
+    }
+
+    void FluidSimulation::removeObstacle(const ObstacleShape& shape) {
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < height; ++y) {
+                if (shape(static_cast<float>(x), static_cast<float>(y)) <= 0.0f) markObstacle(x, y, false);
+            }
+        }
+    }
+
+    void FluidSimulation::clearObstacles() {
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < height; ++y) {
+                markObstacle(x, y, false);
             }
         }
     }
 
+    void FluidSimulation::setObstacles(const ObstacleBitmap& bitmap) {
+        if (bitmap.width <= 0 || bitmap.height <= 0) return;
+
+        for (int x = 0; x < width; ++x) {
+            const size_t bx = static_cast<size_t>(x) * bitmap.width / width;
+            for (int y = 0; y < height; ++y) {
+                const size_t by = static_cast<size_t>(y) * bitmap.height / height;
+                markObstacle(x, y, bitmap.solid[by * bitmap.width + bx] != 0);
+            }
+        }
+    }
+
+    bool FluidSimulation::loadObstacles(const std::string& path) {
+        ObstacleBitmap bitmap;
+        if (!LoadObstacleBitmap(path, bitmap)) return false;
+
+        setObstacles(bitmap);
+        return true;
+    }
+
+    void FluidSimulation::invalidateObstacles() {
+        dirtyColumns.assign(width, 1);
+        obstaclesDirty = true;
+    }
+
+    void FluidSimulation::compileColumn(int x) {
+        std::vector<FluidRun>& runs = fluidRuns[x];
+        runs.clear();
+        if (x < 1 || x >= width - 1) return;
+
+        const std::vector<FluidCell>& column = grid[x];
+        CompileFluidRuns(height, [&](int y) { return column[y].obstacle; }, runs);
+    }
+
+    void FluidSimulation::compileObstacles() {
+        if (!obstaclesDirty) return;
+
+        if (fluidRuns.size() != static_cast<size_t>(width) || dirtyColumns.size() != static_cast<size_t>(width)) {
+            fluidRuns.assign(width, {});
+            dirtyColumns.assign(width, 1);
+        }
+
+        // Runs only depend on their own column.
+        for (int x = 0; x < width; ++x) {
+            if (dirtyColumns[x]) compileColumn(x);
+        }
+
+        std::fill(dirtyColumns.begin(), dirtyColumns.end(), 0);
+        obstaclesDirty = false;
+    }
+
     void FluidSimulation::advect(float dt) {
-        std::vector<std::vector<FluidCell>> tempGrid = grid;
+        compileObstacles();
+
+        // Results go to flat scratch fields; cells that are not advected keep their value.
+        const size_t n = static_cast<size_t>(width) * height;
+        float* smoke = scratch.allocate<float>(n);
+        float* u = scratch.allocate<float>(n);
+        float* v = scratch.allocate<float>(n);
+
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < height; ++y) {
+                const size_t i = static_cast<size_t>(x) * height + y;
+                smoke[i] = grid[x][y].smoke;
+                u[i] = grid[x][y].velocity.u;
+                v[i] = grid[x][y].velocity.v;
+            }
+        }
 
         for (int x = 1; x < width - 1; ++x) {
-            for (int y = 1; y < height - 1; ++y) {
-                if (grid[x][y].obstacle) continue;
+            for (const FluidRun& run : fluidRuns[x]) {
+                for (int y = run.begin; y < run.end; ++y) {
+                    float x0 = x - grid[x][y].velocity.u * dt;
+                    float y0 = y - grid[x][y].velocity.v * dt;
 
-                float x0 = x - grid[x][y].velocity.u * dt;
-                float y0 = y - grid[x][y].velocity.v * dt;
+                    x0 = std::max(0.0f, std::min(x0, static_cast<float>(width - 1)));
+                    y0 = std::max(0.0f, std::min(y0, static_cast<float>(height - 1)));
 
-                x0 = std::max(0.0f, std::min(x0, static_cast<float>(width - 1)));
-                y0 = std::max(0.0f, std::min(y0, static_cast<float>(height - 1)));
+                    int x0_floor = static_cast<int>(std::floor(x0));
+                    int y0_floor = static_cast<int>(std::floor(y0));
 
-                int x0_floor = static_cast<int>(std::floor(x0));
-                int y0_floor = static_cast<int>(std::floor(y0));
+                    float t_x = x0 - x0_floor;
+                    float t_y = y0 - y0_floor;
 
-                float t_x = x0 - x0_floor;
-                float t_y = y0 - y0_floor;
+                    if (x0_floor >= 0 && x0_floor + 1 < width && y0_floor >= 0 && y0_floor + 1 < height) {
+                        const size_t i = static_cast<size_t>(x) * height + y;
 
-                if (x0_floor >= 0 && x0_floor + 1 < width && y0_floor >= 0 && y0_floor + 1 < height) {
-                    tempGrid[x][y].smoke = (1 - t_x) * (1 - t_y) * grid[x0_floor][y0_floor].smoke +
-                        t_x * (1 - t_y) * grid[x0_floor + 1][y0_floor].smoke +
-                        (1 - t_x) * t_y * grid[x0_floor][y0_floor + 1].smoke +
-                        t_x * t_y * grid[x0_floor + 1][y0_floor + 1].smoke;
+                        smoke[i] = (1 - t_x) * (1 - t_y) * grid[x0_floor][y0_floor].smoke +
+                            t_x * (1 - t_y) * grid[x0_floor + 1][y0_floor].smoke +
+                            (1 - t_x) * t_y * grid[x0_floor][y0_floor + 1].smoke +
+                            t_x * t_y * grid[x0_floor + 1][y0_floor + 1].smoke;
 
-                    tempGrid[x][y].velocity.u = (1 - t_x) * (1 - t_y) * grid[x0_floor][y0_floor].velocity.u +
-                        t_x * (1 - t_y) * grid[x0_floor + 1][y0_floor].velocity.u +
-                        (1 - t_x) * t_y * grid[x0_floor][y0_floor + 1].velocity.u +
-                        t_x * t_y * grid[x0_floor + 1][y0_floor + 1].velocity.u;
+                        u[i] = (1 - t_x) * (1 - t_y) * grid[x0_floor][y0_floor].velocity.u +
+                            t_x * (1 - t_y) * grid[x0_floor + 1][y0_floor].velocity.u +
+                            (1 - t_x) * t_y * grid[x0_floor][y0_floor + 1].velocity.u +
+                            t_x * t_y * grid[x0_floor + 1][y0_floor + 1].velocity.u;
 
-                    tempGrid[x][y].velocity.v = (1 - t_x) * (1 - t_y) * grid[x0_floor][y0_floor].velocity.v +
-                        t_x * (1 - t_y) * grid[x0_floor + 1][y0_floor].velocity.v +
-                        (1 - t_x) * t_y * grid[x0_floor][y0_floor + 1].velocity.v +
-                        t_x * t_y * grid[x0_floor + 1][y0_floor + 1].velocity.v;
+                        v[i] = (1 - t_x) * (1 - t_y) * grid[x0_floor][y0_floor].velocity.v +
+                            t_x * (1 - t_y) * grid[x0_floor + 1][y0_floor].velocity.v +
+                            (1 - t_x) * t_y * grid[x0_floor][y0_floor + 1].velocity.v +
+                            t_x * t_y * grid[x0_floor + 1][y0_floor + 1].velocity.v;
+                    }
                 }
             }
         }
 
-        grid = tempGrid;
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < height; ++y) {
+                const size_t i = static_cast<size_t>(x) * height + y;
+                grid[x][y].smoke = smoke[i];
+                grid[x][y].velocity.u = u[i];
+                grid[x][y].velocity.v = v[i];
+            }
+        }
     }
 
     void FluidSimulation::diffuse(float diff, float dt) {
-        std::vector<std::vector<FluidCell>> tempGrid = grid;
+        compileObstacles();
 
-        for (int k = 0; k < 20; ++k) { // 20 iterations for Gauss-Seidel relaxation
-            for (int x = 1; x < width - 1; ++x) {
-                for (int y = 1; y < height - 1; ++y) {
-                    if (grid[x][y].obstacle) continue;
-
-                    tempGrid[x][y].smoke = (grid[x][y].smoke + diff * dt * (
-                        grid[x + 1][y].smoke +
-                        grid[x - 1][y].smoke +
-                        grid[x][y + 1].smoke +
-                        grid[x][y - 1].smoke)) / (1 + 4 * diff * dt);
+        const size_t n = static_cast<size_t>(width) * height;
+        const size_t h = static_cast<size_t>(height);
+        float* source = scratch.allocate<float>(n);
+        float* smoke = scratch.allocate<float>(n);
+
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < height; ++y) {
+                source[x * h + y] = grid[x][y].smoke;
+            }
+        }
+        std::copy(source, source + n, smoke);
+
+        // Every relaxation pass reads the pre-diffusion smoke, so the passes all
+        // produce the same values and a single one is enough.
+        const float a = diff * dt;
+        const float denominator = 1 + 4 * diff * dt;
+        for (int x = 1; x < width - 1; ++x) {
+            for (const FluidRun& run : fluidRuns[x]) {
+                for (size_t i = x * h + run.begin; i < x * h + run.end; ++i) {
+                    smoke[i] = (source[i] + a * (source[i + h] + source[i - h] + source[i + 1] + source[i - 1])) / denominator;
                 }
             }
         }
 
-        grid = tempGrid;
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < height; ++y) {
+                grid[x][y].smoke = smoke[x * h + y];
+            }
+        }
     }
 
     void FluidSimulation::project(float dt) {
-        std::vector<std::vector<float>> div(width, std::vector<float>(height, 0.0f));
-        std::vector<std::vector<float>> p(width, std::vector<float>(height, 0.0f));
+        compileObstacles();
 
-        for (int x = 1; x < width - 1; ++x) {
-            for (int y = 1; y < height - 1; ++y) {
-                if (grid[x][y].obstacle) continue;
+        const size_t n = static_cast<size_t>(width) * height;
+        float* u = scratch.allocate<float>(n);
+        float* v = scratch.allocate<float>(n);
+        float* div = scratch.allocate<float>(n);
+        float* p = scratch.allocate<float>(n);
+        std::fill(div, div + n, 0.0f);
+        std::fill(p, p + n, 0.0f);
 
-                div[x][y] = -0.5f * (grid[x + 1][y].velocity.u - grid[x - 1][y].velocity.u +
-                    grid[x][y + 1].velocity.v - grid[x][y - 1].velocity.v) / width;
-                p[x][y] = 0.0f;
+        // Column-major like grid: (x, y) -> x * h + y
+        const size_t h = static_cast<size_t>(height);
+
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < height; ++y) {
+                u[x * h + y] = grid[x][y].velocity.u;
+                v[x * h + y] = grid[x][y].velocity.v;
+            }
+        }
+
+        for (int x = 1; x < width - 1; ++x) {
+            for (const FluidRun& run : fluidRuns[x]) {
+                for (size_t i = x * h + run.begin; i < x * h + run.end; ++i) {
+                    div[i] = -0.5f * (u[i + h] - u[i - h] + v[i + 1] - v[i - 1]) / width;
+                }
             }
         }
 
         for (int k = 0; k < 20; ++k) { // 20 iterations for Gauss-Seidel relaxation
             for (int x = 1; x < width - 1; ++x) {
-                for (int y = 1; y < height - 1; ++y) {
-                    if (grid[x][y].obstacle) continue;
-
-                    p[x][y] = (div[x][y] + p[x + 1][y] + p[x - 1][y] + p[x][y + 1] + p[x][y - 1]) / 4.0f;
+                for (const FluidRun& run : fluidRuns[x]) {
+                    for (size_t i = x * h + run.begin; i < x * h + run.end; ++i) {
+                        p[i] = (div[i] + p[i + h] + p[i - h] + p[i + 1] + p[i - 1]) / 4.0f;
+                    }
                 }
             }
         }
 
         for (int x = 1; x < width - 1; ++x) {
-            for (int y = 1; y < height - 1; ++y) {
-                if (grid[x][y].obstacle) continue;
-
-                grid[x][y].velocity.u -= 0.5f * width * (p[x + 1][y] - p[x - 1][y]);
-                grid[x][y].velocity.v -= 0.5f * height * (p[x][y + 1] - p[x][y - 1]);
+            for (const FluidRun& run : fluidRuns[x]) {
+                for (int y = run.begin; y < run.end; ++y) {
+                    const size_t i = x * h + y;
+                    grid[x][y].velocity.u = u[i] - 0.5f * width * (p[i + h] - p[i - h]);
+                    grid[x][y].velocity.v = v[i] - 0.5f * height * (p[i + 1] - p[i - 1]);
+                }
             }
         }
     }
@@ -122,6 +267,9 @@ namespace QP {
         advect(dt);
         diffuse(0.1f, dt); // diffusion coefficient
         project(dt);
+
+        // All per-step temporaries are released at once.
+        scratch.reset();
     }
 
     void FluidSimulation::addSmoke(int x, int y, float amount) {
@@ -140,4 +288,14 @@ namespace QP {
     const std::vector<std::vector<FluidCell>>& FluidSimulation::getGrid() const {
         return grid;
     }
+
+    void CaptureFrame(const FluidSimulation& sim, FluidFrame& frame) {
+        frame.width = sim.width;
+        frame.height = sim.height;
+        frame.cells.resize(static_cast<size_t>(sim.width) * sim.height);
+
+        auto out = frame.cells.begin();
+        for (const auto& column : sim.grid)
+            out = std::copy(column.begin(), column.end(), out);
+    }
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "Arena.h"
+#include "Obstacles.h"
+
+#include <string>
 #include <vector>
 
 namespace QP {
@@ -16,6 +20,40 @@ namespace QP {
         bool obstacle;
     };
 
+    /// Contiguous fluid cells [begin, end) along y within one grid column.
+    struct FluidRun {
+        int begin;
+        int end;
+    };
+
+    /// Interior fluid runs (1 <= y < height - 1) of one column; solid(y) says
+    /// whether cell y is an obstacle. Shared by every solver on this grid layout.
+    template<typename Solid>
+    void CompileFluidRuns(int height, Solid&& solid, std::vector<FluidRun>& runs) {
+        runs.clear();
+        for (int y = 1; y < height - 1;) {
+            while (y < height - 1 && solid(y)) ++y;
+            const int begin = y;
+            while (y < height - 1 && !solid(y)) ++y;
+            if (y > begin) runs.push_back({ begin, y });
+        }
+    }
+
+    /// The obstacle a new FluidSimulation starts with.
+    ObstacleShape DefaultFluidObstacle();
+
+    /// Completed frame handed to readers, column-major like grid (x * height + y).
+    struct FluidFrame {
+        int width{0};
+        int height{0};
+        std::vector<FluidCell> cells;
+    };
+
+    class FluidSimulation;
+
+    /// Copies the grid, for Publisher<FluidFrame>.
+    void CaptureFrame(const FluidSimulation& sim, FluidFrame& frame);
+
     class FluidSimulation {
     public:
         FluidSimulation(int width, int height);
@@ -25,13 +63,40 @@ namespace QP {
         void addVelocity(int x, int y, float u, float v);
         const std::vector<std::vector<FluidCell>>& getGrid() const;
 
+        /// Obstacle edits mark the touched columns dirty; update() recompiles
+        /// only those before stepping.
+        void setObstacle(int x, int y, bool solid);
+        void addObstacle(const ObstacleShape& shape);
+        void removeObstacle(const ObstacleShape& shape);
+        void clearObstacles();
+
+        /// Replaces all obstacles with a bitmap, scaled to the grid (nearest cell).
+        void setObstacles(const ObstacleBitmap& bitmap);
+        bool loadObstacles(const std::string& path);
+
+        /// Call after writing grid[x][y].obstacle directly or resizing the grid.
+        void invalidateObstacles();
+        void compileObstacles();
+
     public:
         int width;
         int height;
         std::vector<std::vector<FluidCell>> grid;
+        /// Per-step scratch for advect/diffuse/project, reset at the end of update().
+        FrameArena scratch;
+
+        /// Per column x: the interior fluid runs the kernels iterate over.
+        std::vector<std::vector<FluidRun>> fluidRuns;
 
         void advect(float dt);
         void diffuse(float diff, float dt);
         void project(float dt);
+
+    private:
+        void markObstacle(int x, int y, bool solid);
+        void compileColumn(int x);
+
+        std::vector<uint8_t> dirtyColumns;
+        bool obstaclesDirty{true};
     };
 }
\ No newline at end of file
@@ -1,14 +1,20 @@
 #include "Gravity.h"
+#include "Parallel.h"
+#include "Random.h"
+
+#include <algorithm>
 
 
 namespace QP {
 
+	static const float GravitationalConstant = 6.674e-11f;
+
 	static void GravityForce(GravityParticle& p1, GravityParticle& p2){
 		
 		const float m1 = p1.mass;
 		const float m2 = p2.mass;
 
-		const float G = 6.674 * std::pow(10, -11);
+		const float G = GravitationalConstant;
 		const Vec3 diffVector = (p1.position - p2.position); // A Vector From p2 to p1
 		const Vec3 direction = diffVector.normalized();
 		const float r = diffVector.length(); 
@@ -29,34 +35,129 @@ namespace QP {
 		particle.position += particle.velocity * ts;
 	}
 
-	void InitializeParticles(Gravity& sim, int count, float range) {
-		sim.particles.resize(count);
-		std::srand(static_cast<unsigned int>(std::time(nullptr)));
+	// Counter streams, so adding a draw to one distribution never shifts another.
+	enum : uint32_t { StreamPosition = 0, StreamVelocity = 1, StreamMass = 2, StreamRejection = 3 };
 
-		for (int i = 0; i < count; ++i) {
-			GravityParticle particle;
-			particle.position = {
-				static_cast<float>(std::rand()) / RAND_MAX * range - range / 2,
-				static_cast<float>(std::rand()) / RAND_MAX * range - range / 2,
-				static_cast<float>(std::rand()) / RAND_MAX * range - range / 2
-			};
-
-			// Random velocity between 0 and 20
-			particle.velocity = {
-				static_cast<float>(std::rand()) / RAND_MAX * 0.2f,
-				static_cast<float>(std::rand()) / RAND_MAX * 0.2f,
-				static_cast<float>(std::rand()) / RAND_MAX * 0.2f
-			};
+	static Vec3 IsotropicDirection(const std::array<uint32_t, 4>& bits){
+		const float z = UniformFloat(bits[0]) * 2.0f - 1.0f;
+		const float phi = UniformFloat(bits[1]) * 6.2831853f;
+		const float s = std::sqrt(std::max(0.0f, 1.0f - z * z));
+		return { s * std::cos(phi), s * std::sin(phi), z };
+	}
 
-			particle.acceleration = { 0.0f, 0.0f, 0.0f };
+	void InitializeParticles(Gravity& sim, int count, float range, uint64_t seed) {
+		sim.particles.resize(count);
+		const Philox rng(seed);
+
+		ParallelFor(0, static_cast<size_t>(count), [&](size_t begin, size_t end){
+			for (size_t i = begin; i < end; ++i) {
+				const auto p = rng(i, StreamPosition);
+				const auto v = rng(i, StreamVelocity);
+				const auto m = rng(i, StreamMass);
+
+				GravityParticle& particle = sim.particles[i];
+				particle.position = {
+					UniformFloat(p[0]) * range - range / 2,
+					UniformFloat(p[1]) * range - range / 2,
+					UniformFloat(p[2]) * range - range / 2
+				};
+
+				// Random velocity between 0 and 0.2
+				particle.velocity = {
+					UniformFloat(v[0]) * 0.2f,
+					UniformFloat(v[1]) * 0.2f,
+					UniformFloat(v[2]) * 0.2f
+				};
+
+				particle.acceleration = { 0.0f, 0.0f, 0.0f };
+
+				// Mass between 1 million and 10 billion
+				particle.mass = UniformFloat(m[0]) * (10e9f - 1e6f) + 1e6f;
+			}
+		});
+	}
 
-			// Mass between 1 million and 10 billion
-			particle.mass = static_cast<float>(std::rand()) / RAND_MAX * (10e9f - 1e6f) + 1e6f;
+	void InitializePlummerSphere(Gravity& sim, int count, float scaleRadius, float totalMass, uint64_t seed) {
+		sim.particles.resize(count);
+		if (count <= 0) return;
+
+		const Philox rng(seed);
+		const float mass = totalMass / count;
+		const float vScale = std::sqrt(GravitationalConstant * totalMass / scaleRadius);
+
+		ParallelFor(0, static_cast<size_t>(count), [&](size_t begin, size_t end){
+			for (size_t i = begin; i < end; ++i) {
+				const auto p = rng(i, StreamPosition);
+				const auto v = rng(i, StreamVelocity);
+
+				// Invert the cumulative mass profile; clip the far tail.
+				const float X = std::max(UniformFloatOpen(p[2]) * 0.999f, 1e-6f);
+				const float r = scaleRadius / std::sqrt(std::pow(X, -2.0f / 3.0f) - 1.0f);
+
+				// Speed as a fraction q of escape speed, q ~ q^2 (1 - q^2)^3.5 by rejection.
+				float q = 0.0f;
+				for (uint32_t attempt = 0;; ++attempt) {
+					const auto t = rng(i, StreamRejection + 4 * attempt);
+					const float x = UniformFloat(t[0]);
+					const float y = UniformFloat(t[1]) * 0.1f;
+					if (y < x * x * std::pow(1.0f - x * x, 3.5f)) {
+						q = x;
+						break;
+					}
+				}
+
+				const float ratio = r / scaleRadius;
+				const float escape = std::sqrt(2.0f) * vScale * std::pow(1.0f + ratio * ratio, -0.25f);
+
+				GravityParticle& particle = sim.particles[i];
+				particle.position = IsotropicDirection(p) * r;
+				particle.velocity = IsotropicDirection(v) * (q * escape);
+				particle.acceleration = { 0.0f, 0.0f, 0.0f };
+				particle.mass = mass;
+			}
+		});
+	}
 
-			sim.particles[i] = particle;
-		}
+	void InitializeRotatingDisk(Gravity& sim, int count, float innerRadius, float outerRadius,
+		float centralMass, float particleMass, uint64_t seed) {
+		sim.particles.resize(count);
+		if (count <= 0) return;
+
+		GravityParticle& center = sim.particles[0];
+		center.position = { 0.0f, 0.0f, 0.0f };
+		center.velocity = { 0.0f, 0.0f, 0.0f };
+		center.acceleration = { 0.0f, 0.0f, 0.0f };
+		center.mass = centralMass;
+
+		const Philox rng(seed);
+		const float r0 = innerRadius * innerRadius;
+		const float r1 = outerRadius * outerRadius;
+		const float diskMass = particleMass * (count - 1);
+
+		ParallelFor(1, static_cast<size_t>(count), [&](size_t begin, size_t end){
+			for (size_t i = begin; i < end; ++i) {
+				const auto p = rng(i, StreamPosition);
+
+				// Uniform in area between the two radii.
+				const float r = std::sqrt(r0 + UniformFloat(p[0]) * (r1 - r0));
+				const float phi = UniformFloat(p[1]) * 6.2831853f;
+				const float z = (UniformFloat(p[2]) - 0.5f) * 0.01f * (outerRadius - innerRadius);
+
+				// Circular speed from the central body plus the disk mass inside r.
+				const float enclosed = centralMass + diskMass * (r * r - r0) / std::max(r1 - r0, 1e-12f);
+				const float speed = std::sqrt(GravitationalConstant * enclosed / r);
+
+				const float c = std::cos(phi), s = std::sin(phi);
+
+				GravityParticle& particle = sim.particles[i];
+				particle.position = { r * c, r * s, z };
+				particle.velocity = { -s * speed, c * speed, 0.0f };
+				particle.acceleration = { 0.0f, 0.0f, 0.0f };
+				particle.mass = particleMass;
+			}
+		});
 	}
-	
+
 	void UpdateGravity(Gravity& gravity, float ts){
 
 		auto& particles = gravity.particles;
@@ -73,7 +174,16 @@ namespace QP {
 
 		for(auto& particle : particles){
 			UpdateParticle(particle, ts);
-		}   	
+		}
+	}
+
+	void CaptureFrame(const Gravity& sim, GravityFrame& frame){
+		frame.positions.resize(sim.particles.size());
+		frame.masses.resize(sim.particles.size());
+		for(size_t i = 0; i < sim.particles.size(); ++i){
+			frame.positions[i] = sim.particles[i].position;
+			frame.masses[i] = sim.particles[i].mass;
+		}
 	}
 
 
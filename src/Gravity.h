@@ -3,6 +3,7 @@
 #include "Vector.h"
 #include "Timestep.h"
 
+#include <cstdint>
 #include <vector>
 
 namespace QP {
@@ -18,13 +19,32 @@ namespace QP {
 
 	void UpdateParticle(GravityParticle& particle, float ts);
 
+	struct GravityFrame{
+		std::vector<Vec3> positions;
+		std::vector<float> masses;
+	};
+
 	struct Gravity{
 		std::vector<GravityParticle> particles;
 	};
 
-	void InitializeParticles(Gravity& sim, int count, float range);
+	/// Initializers are deterministic for a given seed, independent of thread
+	/// count, and fill the particle array in parallel.
+
+	/// Uniform positions in a cube of side range, velocities in [0, 0.2), masses in [1e6, 1e10).
+	void InitializeParticles(Gravity& sim, int count, float range, uint64_t seed = 0);
+
+	/// Plummer sphere in virial equilibrium (Aarseth, Henon & Wielen 1974), equal masses.
+	void InitializePlummerSphere(Gravity& sim, int count, float scaleRadius, float totalMass, uint64_t seed = 0);
+
+	/// Thin disk in the xy-plane orbiting a central body stored at index 0.
+	void InitializeRotatingDisk(Gravity& sim, int count, float innerRadius, float outerRadius,
+		float centralMass, float particleMass, uint64_t seed = 0);
 
 	void UpdateGravity(Gravity& sim, float ts);
 
+	/// Positions and masses, for Publisher<GravityFrame>.
+	void CaptureFrame(const Gravity& sim, GravityFrame& frame);
+
 }
 
@@ -0,0 +1,111 @@
+#include "Obstacles.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <utility>
+
+namespace QP {
+
+    ObstacleShape CircleObstacle(const Vec2& center, float radius) {
+        return [center, radius](float x, float y) {
+            return std::sqrt((x - center.x) * (x - center.x) + (y - center.y) * (y - center.y)) - radius;
+        };
+    }
+
+    ObstacleShape BoxObstacle(const Vec2& min, const Vec2& max) {
+        const Vec2 center((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f);
+        const Vec2 half((max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f);
+
+        return [center, half](float x, float y) {
+            const float dx = std::fabs(x - center.x) - half.x;
+            const float dy = std::fabs(y - center.y) - half.y;
+            const float outside = std::sqrt(std::max(dx, 0.0f) * std::max(dx, 0.0f) + std::max(dy, 0.0f) * std::max(dy, 0.0f));
+            return outside + std::min(std::max(dx, dy), 0.0f);
+        };
+    }
+
+    ObstacleShape ObstacleUnion(ObstacleShape a, ObstacleShape b) {
+        return [a = std::move(a), b = std::move(b)](float x, float y) {
+            return std::min(a(x, y), b(x, y));
+        };
+    }
+
+    ObstacleShape ObstacleSubtract(ObstacleShape a, ObstacleShape b) {
+        return [a = std::move(a), b = std::move(b)](float x, float y) {
+            return std::max(a(x, y), -b(x, y));
+        };
+    }
+
+    /// Next header or ASCII value token, skipping whitespace and # comments.
+    static bool ReadToken(std::istream& in, int& value) {
+        for (;;) {
+            const int c = in.peek();
+            if (c == EOF) return false;
+            if (c == '#') {
+                std::string comment;
+                std::getline(in, comment);
+            } else if (std::isspace(c)) {
+                in.get();
+            } else {
+                break;
+            }
+        }
+        return static_cast<bool>(in >> value);
+    }
+
+    bool LoadObstacleBitmap(const std::string& path, ObstacleBitmap& bitmap) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+
+        char magic[2];
+        if (!in.read(magic, 2) || magic[0] != 'P') return false;
+
+        const char kind = magic[1];
+        if (kind != '1' && kind != '2' && kind != '4' && kind != '5') return false;
+        const bool bitmapFormat = kind == '1' || kind == '4';
+
+        int width, height, maxValue = 1;
+        if (!ReadToken(in, width) || !ReadToken(in, height)) return false;
+        if (!bitmapFormat && !ReadToken(in, maxValue)) return false;
+        if (width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 65535) return false;
+
+        bitmap.width = width;
+        bitmap.height = height;
+        bitmap.solid.assign(static_cast<size_t>(width) * height, 0);
+
+        if (kind == '1' || kind == '2') {
+            for (uint8_t& solid : bitmap.solid) {
+                int value;
+                if (!ReadToken(in, value)) return false;
+                solid = bitmapFormat ? value != 0 : value * 2 < maxValue;
+            }
+            return true;
+        }
+
+        in.get(); // single whitespace byte before the raster
+
+        if (kind == '4') {
+            // Rows are packed MSB first and padded to whole bytes.
+            std::vector<uint8_t> row((width + 7) / 8);
+            for (int y = 0; y < height; ++y) {
+                if (!in.read(reinterpret_cast<char*>(row.data()), row.size())) return false;
+                for (int x = 0; x < width; ++x)
+                    bitmap.solid[static_cast<size_t>(y) * width + x] = (row[x / 8] >> (7 - x % 8)) & 1;
+            }
+            return true;
+        }
+
+        const size_t bytesPerValue = maxValue > 255 ? 2 : 1;
+        std::vector<uint8_t> raster(bitmap.solid.size() * bytesPerValue);
+        if (!in.read(reinterpret_cast<char*>(raster.data()), raster.size())) return false;
+
+        for (size_t i = 0; i < bitmap.solid.size(); ++i) {
+            const int value = bytesPerValue == 2 ? (raster[2 * i] << 8) | raster[2 * i + 1] : raster[i];
+            bitmap.solid[i] = value * 2 < maxValue;
+        }
+        return true;
+    }
+
+} // namespace QP
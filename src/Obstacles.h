@@ -0,0 +1,38 @@
+/// Obstacle shapes and bitmaps for FluidSimulation.
+///
+/// Shapes are signed distance functions in cell coordinates (cell (x, y) is
+/// sampled at the point (x, y)); a cell is inside when the distance is <= 0.
+
+#pragma once
+
+#include "Vector.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace QP {
+
+    using ObstacleShape = std::function<float(float x, float y)>;
+
+    ObstacleShape CircleObstacle(const Vec2& center, float radius);
+
+    /// Axis-aligned box covering the cells from min to max, inclusive.
+    ObstacleShape BoxObstacle(const Vec2& min, const Vec2& max);
+
+    ObstacleShape ObstacleUnion(ObstacleShape a, ObstacleShape b);
+    ObstacleShape ObstacleSubtract(ObstacleShape a, ObstacleShape b);
+
+    /// Row-major (y * width + x) solid mask.
+    struct ObstacleBitmap {
+        int width{0};
+        int height{0};
+        std::vector<uint8_t> solid;
+    };
+
+    /// Reads a PBM (P1/P4) or PGM (P2/P5) image. Black pixels, or gray values
+    /// below half of the maximum, are solid.
+    bool LoadObstacleBitmap(const std::string& path, ObstacleBitmap& bitmap);
+
+} // namespace QP
@@ -0,0 +1,75 @@
+#include "Parallel.h"
+
+namespace QP {
+
+    WorkerPool::WorkerPool(size_t threads) {
+        workers.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            workers.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+
+    WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    WorkerPool& WorkerPool::Shared() {
+        static WorkerPool pool([] {
+            const unsigned int n = std::thread::hardware_concurrency();
+            return n > 1 ? static_cast<size_t>(n - 1) : size_t(0);
+        }());
+        return pool;
+    }
+
+    void WorkerPool::dispatch(size_t tasks, size_t helpers, Job fn, void* data) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = fn;
+            context = data;
+            taskCount = tasks;
+            next.store(0, std::memory_order_relaxed);
+            participants = helpers;
+            running = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+
+        claim();
+
+        // Every worker acknowledges the generation, so none can still be
+        // reading job or context when the next dispatch replaces them.
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return running == 0; });
+    }
+
+    void WorkerPool::claim() {
+        for (size_t task; (task = next.fetch_add(1, std::memory_order_relaxed)) < taskCount;)
+            job(context, task);
+    }
+
+    void WorkerPool::workerLoop(size_t index) {
+        InsideWorker() = true;
+
+        uint64_t seen = 0;
+        for (;;) {
+            bool participate;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                participate = index < participants;
+            }
+
+            if (participate) claim();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--running == 0) done.notify_one();
+        }
+    }
+
+} // namespace QP
@@ -0,0 +1,135 @@
+/// Minimal fork-join helpers for data-parallel loops.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace QP {
+
+    /// Per-thread cap on the workers ParallelFor may use; 0 means no cap. Batch
+    /// runners that already keep every core busy with independent simulations
+    /// set it to 1 on their worker threads.
+    inline size_t& WorkerLimit() {
+        thread_local size_t limit = 0;
+        return limit;
+    }
+
+    inline size_t WorkerCount() {
+        unsigned int n = std::thread::hardware_concurrency();
+        const size_t count = n > 0 ? n : 1;
+        return WorkerLimit() > 0 ? std::min(count, WorkerLimit()) : count;
+    }
+
+    /// Splits [begin, end) into one contiguous range per hardware thread and
+    /// calls fn(rangeBegin, rangeEnd) on each, the last on the calling thread.
+    /// Ranges shorter than grain elements are not split further, so small
+    /// loops run serially without spawning threads.
+    template<typename F>
+    void ParallelFor(size_t begin, size_t end, F&& fn, size_t grain = 1024) {
+        if (end <= begin) return;
+
+        const size_t count = end - begin;
+        const size_t chunks = std::min(WorkerCount(), std::max<size_t>(count / std::max<size_t>(grain, 1), 1));
+        if (chunks <= 1) {
+            fn(begin, end);
+            return;
+        }
+
+        const size_t step = (count + chunks - 1) / chunks;
+        std::vector<std::thread> threads;
+        threads.reserve(chunks - 1);
+
+        for (size_t c = 0; c + 1 < chunks; ++c) {
+            size_t b = begin + c * step;
+            threads.emplace_back([&fn, b, e = std::min(b + step, end)]() { fn(b, e); });
+        }
+        fn(std::min(begin + (chunks - 1) * step, end), end);
+
+        for (auto& thread : threads) thread.join();
+    }
+
+    /// Persistent worker threads for loops that run many times per step, where
+    /// starting threads on every call would cost more than the loop itself.
+    /// One job runs at a time; a call made while the pool is busy, or from one
+    /// of its own workers, runs serially on the calling thread instead.
+    /// The threads do not survive fork(), so fork before first use.
+    class WorkerPool {
+    public:
+        /// threads workers in addition to the calling thread.
+        explicit WorkerPool(size_t threads);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        /// Process-wide pool with one worker per hardware thread besides the caller.
+        static WorkerPool& Shared();
+
+        /// Calls fn(task) for every task in [0, tasks), on up to WorkerCount()
+        /// threads including the caller, and returns when all have finished.
+        template<typename F>
+        void run(size_t tasks, F&& fn) {
+            const size_t helpers = std::min({ workers.size(), WorkerCount() - 1, tasks > 0 ? tasks - 1 : 0 });
+            if (helpers == 0 || InsideWorker() || !busy.try_lock()) {
+                for (size_t task = 0; task < tasks; ++task) fn(task);
+                return;
+            }
+
+            using Fn = std::remove_reference_t<F>;
+            dispatch(tasks, helpers, [](void* context, size_t task) { (*static_cast<Fn*>(context))(task); }, &fn);
+            busy.unlock();
+        }
+
+    private:
+        using Job = void (*)(void* context, size_t task);
+
+        static bool& InsideWorker() {
+            thread_local bool inside = false;
+            return inside;
+        }
+
+        void dispatch(size_t tasks, size_t helpers, Job job, void* context);
+        void workerLoop(size_t index);
+        void claim();
+
+        std::vector<std::thread> workers;
+        std::mutex busy;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        uint64_t generation{0};
+        size_t participants{0};
+        size_t running{0};
+        bool stopping{false};
+
+        Job job{nullptr};
+        void* context{nullptr};
+        size_t taskCount{0};
+        std::atomic<size_t> next{0};
+    };
+
+    /// ParallelFor on the shared WorkerPool. [begin, end) is cut into ranges of
+    /// grain elements (the last may be shorter) that the pool threads claim in
+    /// turn, so range boundaries do not depend on the thread count.
+    template<typename F>
+    void PooledFor(size_t begin, size_t end, F&& fn, size_t grain = 1024) {
+        if (end <= begin) return;
+
+        grain = std::max<size_t>(grain, 1);
+        const size_t ranges = (end - begin + grain - 1) / grain;
+        WorkerPool::Shared().run(ranges, [&](size_t r) {
+            const size_t b = begin + r * grain;
+            fn(b, std::min(b + grain, end));
+        });
+    }
+
+} // namespace QP
@@ -0,0 +1,37 @@
+/// Hands completed frames of a solver to one reader thread.
+///
+/// The caller owns the publisher and calls publish(solver) after each step;
+/// the frame is filled by the CaptureFrame overload declared next to the
+/// solver and its frame type. Solvers themselves hold no publishing state, so
+/// they stay plain copyable values.
+
+#pragma once
+
+#include "TripleBuffer.h"
+
+#include <cstdint>
+
+namespace QP {
+
+    template<typename Frame>
+    class Publisher {
+    public:
+        // Producer side
+
+        template<typename Solver>
+        void publish(const Solver& solver) {
+            CaptureFrame(solver, buffer.writeBuffer());
+            buffer.publish();
+        }
+
+        // Consumer side, see TripleBuffer
+
+        bool update() { return buffer.update(); }
+        const Frame& read() const { return buffer.read(); }
+        uint64_t sequence() const { return buffer.sequence(); }
+
+    private:
+        TripleBuffer<Frame> buffer;
+    };
+
+} // namespace QP
@@ -0,0 +1,64 @@
+/// Counter-based random numbers (Philox4x32-10, Salmon et al. 2011).
+///
+/// A draw is a pure function of (seed, counter, stream): there is no state to
+/// advance, so any element of a large initialization can be generated
+/// independently, in any order and on any thread, and a seed always yields
+/// the same sequence.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace QP {
+
+    class Philox {
+    public:
+        explicit Philox(uint64_t seed = 0)
+            : key0(static_cast<uint32_t>(seed)), key1(static_cast<uint32_t>(seed >> 32)) {}
+
+        std::array<uint32_t, 4> operator()(uint64_t counter, uint32_t stream = 0) const {
+            uint32_t c0 = static_cast<uint32_t>(counter);
+            uint32_t c1 = static_cast<uint32_t>(counter >> 32);
+            uint32_t c2 = stream;
+            uint32_t c3 = 0;
+            uint32_t k0 = key0, k1 = key1;
+
+            for (int round = 0; round < 10; ++round) {
+                uint64_t p0 = static_cast<uint64_t>(M0) * c0;
+                uint64_t p1 = static_cast<uint64_t>(M1) * c2;
+
+                uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+                uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+                c1 = static_cast<uint32_t>(p1);
+                c3 = static_cast<uint32_t>(p0);
+                c0 = n0;
+                c2 = n2;
+
+                k0 += W0;
+                k1 += W1;
+            }
+
+            return { c0, c1, c2, c3 };
+        }
+
+    private:
+        static constexpr uint32_t M0 = 0xD2511F53u;
+        static constexpr uint32_t M1 = 0xCD9E8D57u;
+        static constexpr uint32_t W0 = 0x9E3779B9u;
+        static constexpr uint32_t W1 = 0xBB67AE85u;
+
+        uint32_t key0, key1;
+    };
+
+    /// Uniform float in [0, 1) from the top 24 bits.
+    inline float UniformFloat(uint32_t bits) {
+        return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+    }
+
+    /// Uniform float in (0, 1], safe to pass to log().
+    inline float UniformFloatOpen(uint32_t bits) {
+        return (static_cast<float>(bits >> 8) + 1.0f) * (1.0f / 16777216.0f);
+    }
+
+} // namespace QP
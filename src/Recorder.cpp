@@ -0,0 +1,288 @@
+#include "Recorder.h"
+#include "Fluid.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace QP {
+
+    static const char RecordingMagic[8] = { 'Q', 'P', 'R', 'E', 'C', 0, 0, 0 };
+
+    static size_t RunLength(const uint8_t* data, size_t i, size_t size) {
+        size_t r = 1;
+        while (i + r < size && r < 129 && data[i + r] == data[i]) ++r;
+        return r;
+    }
+
+    void EncodeRLE(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+        out.clear();
+
+        size_t i = 0;
+        while (i < size) {
+            size_t run = RunLength(data, i, size);
+            if (run >= 2) {
+                out.push_back(static_cast<uint8_t>(run + 126));
+                out.push_back(data[i]);
+                i += run;
+                continue;
+            }
+
+            // Collect literals until a run of three or more starts.
+            size_t start = i;
+            size_t count = 0;
+            while (i < size && count < 128) {
+                if (i + 2 < size && data[i] == data[i + 1] && data[i] == data[i + 2]) break;
+                ++i;
+                ++count;
+            }
+            out.push_back(static_cast<uint8_t>(count - 1));
+            out.insert(out.end(), data + start, data + start + count);
+        }
+    }
+
+    bool DecodeRLE(const uint8_t* data, size_t size, uint8_t* out, size_t outSize) {
+        size_t i = 0, o = 0;
+        while (i < size) {
+            uint8_t c = data[i++];
+            if (c < 128) {
+                size_t count = static_cast<size_t>(c) + 1;
+                if (i + count > size || o + count > outSize) return false;
+                std::memcpy(out + o, data + i, count);
+                i += count;
+                o += count;
+            } else {
+                size_t count = static_cast<size_t>(c) - 126;
+                if (i >= size || o + count > outSize) return false;
+                std::memset(out + o, data[i++], count);
+                o += count;
+            }
+        }
+        return o == outSize;
+    }
+
+
+    FrameRecorder::FrameRecorder(int width, int height, float maxValue, size_t queueCapacity, int keyframeInterval)
+        : width(width), height(height), maxValue(maxValue),
+          capacity(std::max<size_t>(queueCapacity, 1)), keyframeInterval(std::max(keyframeInterval, 1)) {
+    }
+
+    FrameRecorder::~FrameRecorder() {
+        close();
+    }
+
+    bool FrameRecorder::open(const std::string& path) {
+        close();
+
+        if (path == "-") {
+            file = stdout;
+            ownsFile = false;
+        } else {
+            file = std::fopen(path.c_str(), "wb");
+            ownsFile = true;
+        }
+        if (!file) return false;
+
+        RecordingHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, RecordingMagic, sizeof(header.magic));
+        header.version = RecordingVersion;
+        header.width = static_cast<uint32_t>(width);
+        header.height = static_cast<uint32_t>(height);
+        header.maxValue = maxValue;
+        if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+            if (ownsFile) std::fclose(file);
+            file = nullptr;
+            return false;
+        }
+
+        frameIndex = 0;
+        failed = false;
+        stopping = false;
+        counters = RecorderStats();
+        writer = std::thread(&FrameRecorder::writerLoop, this);
+        return true;
+    }
+
+    void FrameRecorder::close() {
+        if (!file) return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        notEmpty.notify_one();
+        writer.join();
+
+        if (std::fflush(file) != 0) failed = true;
+        if (ownsFile && std::fclose(file) != 0) failed = true;
+        counters.writeFailed = failed;
+        file = nullptr;
+        queue.clear();
+    }
+
+    std::vector<uint8_t> FrameRecorder::acquireBuffer() {
+        std::vector<uint8_t> buffer;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!freeBuffers.empty()) {
+                buffer = std::move(freeBuffers.back());
+                freeBuffers.pop_back();
+            }
+        }
+        buffer.resize(static_cast<size_t>(width) * height);
+        return buffer;
+    }
+
+    void FrameRecorder::submit(std::vector<uint8_t>&& cells) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return queue.size() < capacity; });
+        queue.push_back({ frameIndex++, std::move(cells) });
+        lock.unlock();
+        notEmpty.notify_one();
+    }
+
+    void FrameRecorder::record(const FluidSimulation& sim) {
+        if (!isOpen() || sim.width != width || sim.height != height) return;
+
+        std::vector<uint8_t> cells = acquireBuffer();
+        const float scale = 254.0f / maxValue;
+
+        for (int x = 0; x < width; ++x) {
+            const std::vector<FluidCell>& column = sim.grid[x];
+            for (int y = 0; y < height; ++y) {
+                const FluidCell& cell = column[y];
+                float q = std::min(std::max(cell.smoke * scale, 0.0f), 254.0f);
+                cells[static_cast<size_t>(y) * width + x] = cell.obstacle ? RecordingObstacle : static_cast<uint8_t>(q + 0.5f);
+            }
+        }
+
+        submit(std::move(cells));
+    }
+
+    void FrameRecorder::record(const float* values, const uint8_t* obstacles) {
+        if (!isOpen()) return;
+
+        std::vector<uint8_t> cells = acquireBuffer();
+        const float scale = 254.0f / maxValue;
+        const size_t n = cells.size();
+
+        for (size_t i = 0; i < n; ++i) {
+            float q = std::min(std::max(values[i] * scale, 0.0f), 254.0f);
+            cells[i] = (obstacles && obstacles[i]) ? RecordingObstacle : static_cast<uint8_t>(q + 0.5f);
+        }
+
+        submit(std::move(cells));
+    }
+
+    RecorderStats FrameRecorder::stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return counters;
+    }
+
+    void FrameRecorder::writerLoop() {
+        const size_t n = static_cast<size_t>(width) * height;
+        std::vector<uint8_t> previous(n, 0);
+        std::vector<uint8_t> delta(n);
+        std::vector<uint8_t> encoded;
+
+        while (true) {
+            Frame frame;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                notEmpty.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) break;
+                frame = std::move(queue.front());
+                queue.pop_front();
+            }
+            notFull.notify_one();
+
+            const bool keyframe = frame.index % keyframeInterval == 0;
+            if (keyframe) std::fill(previous.begin(), previous.end(), 0);
+
+            // Byte-wise difference wraps mod 256 and turns static regions into zero runs.
+            for (size_t i = 0; i < n; ++i)
+                delta[i] = static_cast<uint8_t>(frame.cells[i] - previous[i]);
+
+            EncodeRLE(delta.data(), n, encoded);
+
+            // After a failure the queue is still drained so record() never blocks.
+            if (!failed) {
+                uint8_t flags = keyframe ? RecordingKeyframe : 0;
+                uint32_t size = static_cast<uint32_t>(encoded.size());
+                const bool written =
+                    std::fwrite(&frame.index, sizeof(frame.index), 1, file) == 1 &&
+                    std::fwrite(&flags, sizeof(flags), 1, file) == 1 &&
+                    std::fwrite(&size, sizeof(size), 1, file) == 1 &&
+                    std::fwrite(encoded.data(), 1, encoded.size(), file) == encoded.size() &&
+                    !std::ferror(file);
+                if (!written) failed = true;
+            }
+
+            previous.swap(frame.cells);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (failed) {
+                counters.writeFailed = true;
+            } else {
+                counters.frames++;
+                counters.rawBytes += n;
+                counters.encodedBytes += encoded.size() + sizeof(uint32_t) * 2 + 1;
+            }
+            freeBuffers.push_back(std::move(frame.cells));
+        }
+    }
+
+
+    RecordingReader::~RecordingReader() {
+        close();
+    }
+
+    bool RecordingReader::open(const std::string& path) {
+        close();
+
+        file = path == "-" ? stdin : std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+
+        if (std::fread(&hdr, sizeof(hdr), 1, file) != 1 ||
+            std::memcmp(hdr.magic, RecordingMagic, sizeof(RecordingMagic)) != 0 ||
+            hdr.version != RecordingVersion) {
+            close();
+            return false;
+        }
+
+        previous.assign(static_cast<size_t>(hdr.width) * hdr.height, 0);
+        return true;
+    }
+
+    void RecordingReader::close() {
+        if (file && file != stdin) std::fclose(file);
+        file = nullptr;
+    }
+
+    bool RecordingReader::next(std::vector<uint8_t>& cells, uint32_t* frameIndex) {
+        if (!file) return false;
+
+        uint32_t index, size;
+        uint8_t flags;
+        if (std::fread(&index, sizeof(index), 1, file) != 1 ||
+            std::fread(&flags, sizeof(flags), 1, file) != 1 ||
+            std::fread(&size, sizeof(size), 1, file) != 1)
+            return false;
+
+        encoded.resize(size);
+        if (size > 0 && std::fread(encoded.data(), 1, size, file) != size) return false;
+
+        const size_t n = previous.size();
+        cells.resize(n);
+        if (!DecodeRLE(encoded.data(), encoded.size(), cells.data(), n)) return false;
+
+        if (flags & RecordingKeyframe) std::fill(previous.begin(), previous.end(), 0);
+        for (size_t i = 0; i < n; ++i)
+            cells[i] = static_cast<uint8_t>(cells[i] + previous[i]);
+
+        previous = cells;
+        if (frameIndex) *frameIndex = index;
+        return true;
+    }
+
+} // namespace QP
@@ -0,0 +1,125 @@
+/// Headless frame recorder for offline visualization.
+///
+/// Each frame is quantized to one byte per cell, delta-encoded against the
+/// previous frame and run-length compressed. The step thread only quantizes;
+/// encoding and I/O happen on a background writer fed through a bounded queue.
+///
+/// Stream layout: RecordingHeader, then per frame
+///   uint32 frameIndex | uint8 flags | uint32 encodedSize | encoded bytes
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace QP {
+
+    class FluidSimulation;
+
+    constexpr uint32_t RecordingVersion = 1;
+    constexpr uint8_t RecordingKeyframe = 1;
+    /// Quantized value reserved for obstacle cells.
+    constexpr uint8_t RecordingObstacle = 255;
+
+    struct RecordingHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        float maxValue;
+    };
+
+    struct RecorderStats {
+        uint64_t frames{0};
+        uint64_t rawBytes{0};
+        uint64_t encodedBytes{0};
+        /// Set once a write fails (full disk, closed pipe); later frames are dropped.
+        bool writeFailed{false};
+    };
+
+    class FrameRecorder {
+    public:
+        FrameRecorder(int width, int height, float maxValue = 1.0f, size_t queueCapacity = 8, int keyframeInterval = 60);
+        ~FrameRecorder();
+
+        FrameRecorder(const FrameRecorder&) = delete;
+        FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+        /// Opens a file or named pipe. "-" writes to stdout.
+        bool open(const std::string& path);
+        void close();
+
+        /// False once closed or after a write error.
+        bool isOpen() const { return file != nullptr && !failed; }
+
+        /// Records the smoke field; blocks only when the writer falls queueCapacity frames behind.
+        void record(const FluidSimulation& sim);
+
+        /// Records width * height values in row-major (y * width + x) order.
+        void record(const float* values, const uint8_t* obstacles = nullptr);
+
+        RecorderStats stats() const;
+
+    private:
+        struct Frame {
+            uint32_t index;
+            std::vector<uint8_t> cells;
+        };
+
+        std::vector<uint8_t> acquireBuffer();
+        void submit(std::vector<uint8_t>&& cells);
+        void writerLoop();
+
+        int width, height;
+        float maxValue;
+        size_t capacity;
+        int keyframeInterval;
+
+        std::FILE* file{nullptr};
+        bool ownsFile{false};
+        uint32_t frameIndex{0};
+
+        std::thread writer;
+        mutable std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+        std::deque<Frame> queue;
+        std::vector<std::vector<uint8_t>> freeBuffers;
+        bool stopping{false};
+        std::atomic<bool> failed{false};
+        RecorderStats counters;
+    };
+
+    /// Reads back a recording frame by frame, undoing the RLE and delta stages.
+    class RecordingReader {
+    public:
+        ~RecordingReader();
+
+        bool open(const std::string& path);
+        void close();
+
+        const RecordingHeader& header() const { return hdr; }
+
+        /// Decodes the next frame into quantized cells; returns false at end of stream.
+        bool next(std::vector<uint8_t>& cells, uint32_t* frameIndex = nullptr);
+
+    private:
+        std::FILE* file{nullptr};
+        RecordingHeader hdr{};
+        std::vector<uint8_t> previous;
+        std::vector<uint8_t> encoded;
+    };
+
+    /// PackBits-style RLE: control byte c < 128 is followed by c + 1 literals,
+    /// c >= 128 by one byte repeated c - 126 times.
+    void EncodeRLE(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+    bool DecodeRLE(const uint8_t* data, size_t size, uint8_t* out, size_t outSize);
+
+} // namespace QP
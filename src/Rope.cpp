@@ -29,6 +29,8 @@ namespace QP {
 
 
     void Rope::applyForce(const Vec2& force) {
+        if (force.x != 0.0f || force.y != 0.0f) wake();
+
         // Start from the second particle to apply force
         for (size_t i = 1; i < particles.size(); ++i) {
             particles[i].applyForce(force);
@@ -36,6 +38,8 @@ namespace QP {
     }
 
     void Rope::applyMouseForce(const Vec2& mousePos) {
+        wake();
+
         for (auto& particle : particles) {
             Vec2 force = mousePos - particle.position;
             particle.applyForce(force);
@@ -43,10 +47,14 @@ namespace QP {
     }
 
     void Rope::update(float dt) {
+        if (sleeping) return;
 
+        // Gravity is always present, so it must not count as a wake-up force.
         Vec2 gravity(0, -9.81f);
 
-        applyForce(gravity);
+        for (size_t i = 1; i < particles.size(); ++i) {
+            particles[i].applyForce(gravity);
+        }
 
         for (auto& particle : particles) {
             particle.update(dt);
@@ -61,5 +69,46 @@ namespace QP {
         if (!particles.empty()) {
             particles[0].position = particles[0].prevPosition;
         }
+
+        updateSleep(dt);
+    }
+
+    void Rope::updateSleep(float dt) {
+        const float maxStep = sleepVelocity * dt;
+        bool resting = true;
+
+        for (const auto& particle : particles) {
+            if ((particle.position - particle.prevPosition).length() > maxStep) {
+                resting = false;
+                break;
+            }
+        }
+
+        float error = 0.0f;
+        for (const auto& constraint : constraints) {
+            error += std::abs((constraint.p2->position - constraint.p1->position).length() - constraint.restLength);
+        }
+        if (std::abs(error - constraintError) > sleepError) resting = false;
+        constraintError = error;
+
+        restFrames = resting ? restFrames + 1 : 0;
+        if (restFrames < sleepFrames) return;
+
+        sleeping = true;
+        for (auto& particle : particles) {
+            particle.prevPosition = particle.position;
+            particle.acceleration = Vec2(0, 0);
+        }
+    }
+
+    void Rope::wake() {
+        sleeping = false;
+        restFrames = 0;
+    }
+
+    void CaptureFrame(const Rope& rope, RopeFrame& frame) {
+        frame.positions.resize(rope.particles.size());
+        for (size_t i = 0; i < rope.particles.size(); ++i)
+            frame.positions[i] = rope.particles[i].position;
     }
 }
\ No newline at end of file
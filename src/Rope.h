@@ -35,6 +35,11 @@ namespace QP {
     };
 
 
+    struct RopeFrame {
+        std::vector<Vec2> positions;
+    };
+
+
     class Rope {
     public:
 
@@ -52,13 +57,34 @@ namespace QP {
 
         void applyForce(const Vec2& force);
 
-        void Rope::applyMouseForce(const Vec2& mousePos);
+        void applyMouseForce(const Vec2& mousePos);
 
         void update(float dt);
+
+        /// A rope is a single chain, so it sleeps as one island.
+        void wake();
+        bool isSleeping() const { return sleeping; }
+
     
     public:
         std::vector<RopeParticle> particles;
         std::vector<RopeConstraint> constraints;
+
+        /// Same rest test as Cloth: speed below sleepVelocity and total constraint
+        /// error changing by less than sleepError, for sleepFrames updates.
+        float sleepVelocity{0.01f};
+        float sleepError{0.001f};
+        int sleepFrames{60};
+
+    private:
+        void updateSleep(float dt);
+
+        float constraintError{0.0f};
+        int restFrames{0};
+        bool sleeping{false};
         
     };
+
+    /// Particle positions, for Publisher<RopeFrame>.
+    void CaptureFrame(const Rope& rope, RopeFrame& frame);
 }
\ No newline at end of file
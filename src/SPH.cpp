@@ -0,0 +1,183 @@
+#include "SPH.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace QP {
+
+    static const float Pi = 3.14159265f;
+
+    SPHFluid::SPHFluid(const Vec2& boundsMin, const Vec2& boundsMax, float smoothingRadius)
+        : boundsMin(boundsMin), boundsMax(boundsMax), h(smoothingRadius) {
+        const float spacing = h * 0.5f;
+        particleMass = restDensity * spacing * spacing;
+
+        poly6 = 4.0f / (Pi * std::pow(h, 8.0f));
+        spikyGrad = -30.0f / (Pi * std::pow(h, 5.0f));
+        viscLaplacian = 40.0f / (Pi * std::pow(h, 5.0f));
+
+        cellsX = std::max(1, static_cast<int>(std::ceil((boundsMax.x - boundsMin.x) / h)));
+        cellsY = std::max(1, static_cast<int>(std::ceil((boundsMax.y - boundsMin.y) / h)));
+        cellStart.resize(static_cast<size_t>(cellsX) * cellsY + 1);
+    }
+
+    void SPHFluid::addParticle(const Vec2& position, const Vec2& velocity) {
+        positions.push_back(position);
+        velocities.push_back(velocity);
+    }
+
+    void SPHFluid::addBlock(const Vec2& min, const Vec2& max) {
+        const float spacing = h * 0.5f;
+        for (float y = min.y; y <= max.y; y += spacing)
+            for (float x = min.x; x <= max.x; x += spacing)
+                addParticle(Vec2(x, y));
+    }
+
+    int SPHFluid::cellOf(const Vec2& p) const {
+        int cx = static_cast<int>((p.x - boundsMin.x) / h);
+        int cy = static_cast<int>((p.y - boundsMin.y) / h);
+        cx = std::max(0, std::min(cx, cellsX - 1));
+        cy = std::max(0, std::min(cy, cellsY - 1));
+        return cy * cellsX + cx;
+    }
+
+    void SPHFluid::buildCells() {
+        const size_t n = positions.size();
+        const size_t cells = static_cast<size_t>(cellsX) * cellsY;
+
+        cellKeys.resize(n);
+        sortedIndex.resize(n);
+        std::fill(cellStart.begin(), cellStart.end(), 0u);
+
+        for (size_t i = 0; i < n; ++i) {
+            cellKeys[i] = static_cast<uint32_t>(cellOf(positions[i]));
+            cellStart[cellKeys[i] + 1]++;
+        }
+
+        for (size_t c = 0; c < cells; ++c)
+            cellStart[c + 1] += cellStart[c];
+
+        // Stable scatter; cellStart[c] is used as the running cursor and restored below.
+        for (size_t i = 0; i < n; ++i)
+            sortedIndex[cellStart[cellKeys[i]]++] = static_cast<uint32_t>(i);
+
+        for (size_t c = cells; c > 0; --c)
+            cellStart[c] = cellStart[c - 1];
+        cellStart[0] = 0;
+
+        // Permute particle data into cell order.
+        scratch.resize(n);
+        for (size_t i = 0; i < n; ++i) scratch[i] = positions[sortedIndex[i]];
+        positions.swap(scratch);
+        for (size_t i = 0; i < n; ++i) scratch[i] = velocities[sortedIndex[i]];
+        velocities.swap(scratch);
+    }
+
+    void SPHFluid::computeDensities() {
+        const float h2 = h * h;
+
+        PooledFor(0, positions.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const Vec2 pi = positions[i];
+                const int cell = cellOf(pi);
+                const int cx = cell % cellsX, cy = cell / cellsX;
+
+                float density = 0.0f;
+                for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, cellsY - 1); ++ny) {
+                    // Neighboring cells in a row are adjacent, so the three of them form one range.
+                    const int row = ny * cellsX;
+                    const uint32_t first = cellStart[row + std::max(cx - 1, 0)];
+                    const uint32_t last = cellStart[row + std::min(cx + 1, cellsX - 1) + 1];
+
+                    for (uint32_t j = first; j < last; ++j) {
+                        const float dx = positions[j].x - pi.x;
+                        const float dy = positions[j].y - pi.y;
+                        const float r2 = dx * dx + dy * dy;
+                        if (r2 < h2) {
+                            const float w = h2 - r2;
+                            density += w * w * w;
+                        }
+                    }
+                }
+
+                densities[i] = particleMass * poly6 * density;
+                // No negative pressure: it only causes clumping at the free surface.
+                pressures[i] = stiffness * std::max(densities[i] - restDensity, 0.0f);
+            }
+        }, 256);
+    }
+
+    void SPHFluid::computeForces() {
+        PooledFor(0, positions.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const Vec2 pi = positions[i];
+                const Vec2 vi = velocities[i];
+                const int cell = cellOf(pi);
+                const int cx = cell % cellsX, cy = cell / cellsX;
+
+                Vec2 pressureForce, viscosityForce;
+                for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, cellsY - 1); ++ny) {
+                    const int row = ny * cellsX;
+                    const uint32_t first = cellStart[row + std::max(cx - 1, 0)];
+                    const uint32_t last = cellStart[row + std::min(cx + 1, cellsX - 1) + 1];
+
+                    for (uint32_t j = first; j < last; ++j) {
+                        if (j == i) continue;
+
+                        const Vec2 d = positions[j] - pi;
+                        const float r = d.length();
+                        if (r >= h || r < 1e-9f) continue;
+
+                        const float q = h - r;
+                        const float shared = particleMass / densities[j];
+
+                        // Symmetric pressure term. spikyGrad is negative, so positive
+                        // pressure pushes i away from j (d points from i to j).
+                        pressureForce += d * ((1.0f / r) * shared * (pressures[i] + pressures[j]) * 0.5f * spikyGrad * q * q);
+                        viscosityForce += (velocities[j] - vi) * (shared * viscLaplacian * q);
+                    }
+                }
+
+                accelerations[i] = (pressureForce + viscosityForce * viscosity) * (1.0f / densities[i]) + gravity;
+            }
+        }, 256);
+    }
+
+    void SPHFluid::integrate(float dt) {
+        PooledFor(0, positions.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Vec2& v = velocities[i];
+                Vec2& p = positions[i];
+                v += accelerations[i] * dt;
+                p += v * dt;
+
+                if (p.x < boundsMin.x) { p.x = boundsMin.x; v.x *= -boundaryDamping; }
+                if (p.x > boundsMax.x) { p.x = boundsMax.x; v.x *= -boundaryDamping; }
+                if (p.y < boundsMin.y) { p.y = boundsMin.y; v.y *= -boundaryDamping; }
+                if (p.y > boundsMax.y) { p.y = boundsMax.y; v.y *= -boundaryDamping; }
+            }
+        }, 4096);
+    }
+
+    void SPHFluid::update(float dt) {
+        const size_t n = positions.size();
+        densities.resize(n);
+        pressures.resize(n);
+        accelerations.resize(n);
+
+        buildCells();
+        computeDensities();
+        computeForces();
+        integrate(dt);
+    }
+
+    float SPHFluid::maxTimestep() const {
+        float maxSpeed = 0.0f;
+        for (const Vec2& v : velocities)
+            maxSpeed = std::max(maxSpeed, v.length());
+
+        return 0.4f * h / (std::sqrt(stiffness) + maxSpeed);
+    }
+
+} // namespace QP
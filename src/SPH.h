@@ -0,0 +1,67 @@
+/// Lagrangian SPH fluid (Mueller et al. 2003, 2D kernels).
+///
+/// Neighbor search uses a cell-linked list rebuilt every step by counting sort
+/// on the cell key. The particle arrays themselves are permuted into cell
+/// order, so each neighbor cell is a contiguous index range and neighbors are
+/// close in memory. Density and force passes run in parallel over particles.
+
+#pragma once
+
+#include "Vector.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace QP {
+
+    class SPHFluid {
+    public:
+        SPHFluid(const Vec2& boundsMin, const Vec2& boundsMax, float smoothingRadius = 0.05f);
+
+        void addParticle(const Vec2& position, const Vec2& velocity = Vec2());
+
+        /// Fills a rectangle at the rest spacing (half the smoothing radius).
+        void addBlock(const Vec2& min, const Vec2& max);
+
+        void update(float dt);
+
+        size_t size() const { return positions.size(); }
+
+        /// Largest stable step for the current stiffness and velocities (CFL).
+        float maxTimestep() const;
+
+    public:
+        // Particle order changes every update; do not keep indices across steps.
+        std::vector<Vec2> positions;
+        std::vector<Vec2> velocities;
+        std::vector<float> densities;
+        std::vector<float> pressures;
+
+        Vec2 gravity{0.0f, -9.81f};
+        float restDensity{1000.0f};
+        float stiffness{1000.0f};
+        float viscosity{1.0f};
+        float particleMass;
+        float boundaryDamping{0.5f};
+
+    private:
+        void buildCells();
+        void computeDensities();
+        void computeForces();
+        void integrate(float dt);
+
+        int cellOf(const Vec2& p) const;
+
+        Vec2 boundsMin, boundsMax;
+        float h;
+        float poly6, spikyGrad, viscLaplacian;
+        int cellsX, cellsY;
+
+        std::vector<Vec2> accelerations;
+        std::vector<uint32_t> cellKeys;
+        std::vector<uint32_t> cellStart;  ///< cellsX * cellsY + 1 offsets into the sorted arrays
+        std::vector<uint32_t> sortedIndex;
+        std::vector<Vec2> scratch;
+    };
+
+} // namespace QP
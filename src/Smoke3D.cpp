@@ -0,0 +1,221 @@
+#include "Smoke3D.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace QP {
+
+    static uint32_t SpreadBits(uint32_t v) {
+        v &= 0x3FF;
+        v = (v | (v << 16)) & 0x030000FF;
+        v = (v | (v << 8)) & 0x0300F00F;
+        v = (v | (v << 4)) & 0x030C30C3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+
+    static uint32_t MortonCode(uint32_t x, uint32_t y, uint32_t z) {
+        return SpreadBits(x) | (SpreadBits(y) << 1) | (SpreadBits(z) << 2);
+    }
+
+    static int RoundUpToBrick(int n) {
+        return std::max(SmokeBrickSize, (n + SmokeBrickSize - 1) / SmokeBrickSize * SmokeBrickSize);
+    }
+
+    SmokeSimulation3D::SmokeSimulation3D(int width, int height, int depth)
+        : width(RoundUpToBrick(width)), height(RoundUpToBrick(height)), depth(RoundUpToBrick(depth)) {
+        bricksX = this->width / SmokeBrickSize;
+        bricksY = this->height / SmokeBrickSize;
+        bricksZ = this->depth / SmokeBrickSize;
+
+        // Order bricks along the Morton curve; works for any brick counts, not just powers of two.
+        const size_t brickCount = static_cast<size_t>(bricksX) * bricksY * bricksZ;
+        std::vector<std::pair<uint32_t, uint32_t>> codes;
+        codes.reserve(brickCount);
+        for (int bz = 0; bz < bricksZ; ++bz)
+            for (int by = 0; by < bricksY; ++by)
+                for (int bx = 0; bx < bricksX; ++bx)
+                    codes.emplace_back(MortonCode(bx, by, bz), static_cast<uint32_t>((bz * bricksY + by) * bricksX + bx));
+        std::sort(codes.begin(), codes.end());
+
+        brickSlot.resize(brickCount);
+        slotOrigin.resize(brickCount);
+        for (size_t slot = 0; slot < brickCount; ++slot) {
+            brickSlot[codes[slot].second] = static_cast<uint32_t>(slot);
+            slotOrigin[slot] = codes[slot].second;
+        }
+
+        const size_t cells = brickCount * SmokeBrickCells;
+        for (auto* field : { &density, &u, &v, &w, &density0, &u0, &v0, &w0 })
+            field->assign(cells, 0.0f);
+    }
+
+    void SmokeSimulation3D::addSmoke(int x, int y, int z, float amount) {
+        if (contains(x, y, z)) density[index(x, y, z)] += amount;
+    }
+
+    void SmokeSimulation3D::addVelocity(int x, int y, int z, const Vec3& velocity) {
+        if (!contains(x, y, z)) return;
+        const size_t i = index(x, y, z);
+        u[i] += velocity.x;
+        v[i] += velocity.y;
+        w[i] += velocity.z;
+    }
+
+    Vec3 SmokeSimulation3D::velocityAt(int x, int y, int z) const {
+        const size_t i = index(x, y, z);
+        return Vec3(u[i], v[i], w[i]);
+    }
+
+    SmokeSimulation3D::Stencil SmokeSimulation3D::stencil(int x, int y, int z, size_t c) const {
+        // Inside a brick the neighbors are fixed offsets; only brick faces need a lookup.
+        constexpr size_t strideY = SmokeBrickSize;
+        constexpr size_t strideZ = SmokeBrickSize * SmokeBrickSize;
+        const int lx = x & SmokeBrickMask, ly = y & SmokeBrickMask, lz = z & SmokeBrickMask;
+        return {
+            c,
+            lx > 0 ? c - 1 : index(x - 1, y, z),
+            lx < SmokeBrickMask ? c + 1 : index(x + 1, y, z),
+            ly > 0 ? c - strideY : index(x, y - 1, z),
+            ly < SmokeBrickMask ? c + strideY : index(x, y + 1, z),
+            lz > 0 ? c - strideZ : index(x, y, z - 1),
+            lz < SmokeBrickMask ? c + strideZ : index(x, y, z + 1)
+        };
+    }
+
+    float SmokeSimulation3D::sample(const std::vector<float>& field, float x, float y, float z) const {
+        x = std::max(0.0f, std::min(x, static_cast<float>(width - 1)));
+        y = std::max(0.0f, std::min(y, static_cast<float>(height - 1)));
+        z = std::max(0.0f, std::min(z, static_cast<float>(depth - 1)));
+
+        const int x0 = std::min(static_cast<int>(x), width - 2);
+        const int y0 = std::min(static_cast<int>(y), height - 2);
+        const int z0 = std::min(static_cast<int>(z), depth - 2);
+        const float tx = x - x0, ty = y - y0, tz = z - z0;
+
+        const float c00 = field[index(x0, y0, z0)] * (1 - tx) + field[index(x0 + 1, y0, z0)] * tx;
+        const float c10 = field[index(x0, y0 + 1, z0)] * (1 - tx) + field[index(x0 + 1, y0 + 1, z0)] * tx;
+        const float c01 = field[index(x0, y0, z0 + 1)] * (1 - tx) + field[index(x0 + 1, y0, z0 + 1)] * tx;
+        const float c11 = field[index(x0, y0 + 1, z0 + 1)] * (1 - tx) + field[index(x0 + 1, y0 + 1, z0 + 1)] * tx;
+
+        const float c0 = c00 * (1 - ty) + c10 * ty;
+        const float c1 = c01 * (1 - ty) + c11 * ty;
+        return c0 * (1 - tz) + c1 * tz;
+    }
+
+    // Every step makes dozens of these passes, so they run on the persistent
+    // pool rather than starting threads each time; one brick per task.
+    template<typename F>
+    void SmokeSimulation3D::forEachInterior(F&& fn) const {
+        PooledFor(0, slotOrigin.size(), [&](size_t begin, size_t end) {
+            for (size_t slot = begin; slot < end; ++slot) {
+                const uint32_t origin = slotOrigin[slot];
+                const int bx = static_cast<int>(origin % bricksX) * SmokeBrickSize;
+                const int by = static_cast<int>((origin / bricksX) % bricksY) * SmokeBrickSize;
+                const int bz = static_cast<int>(origin / (static_cast<uint32_t>(bricksX) * bricksY)) * SmokeBrickSize;
+
+                // Domain boundary cells are left untouched, as in the 2D solver.
+                const int x0 = std::max(bx, 1), x1 = std::min(bx + SmokeBrickSize, width - 1);
+                const int y0 = std::max(by, 1), y1 = std::min(by + SmokeBrickSize, height - 1);
+                const int z0 = std::max(bz, 1), z1 = std::min(bz + SmokeBrickSize, depth - 1);
+
+                for (int z = z0; z < z1; ++z)
+                    for (int y = y0; y < y1; ++y)
+                        for (int x = x0; x < x1; ++x)
+                            fn(x, y, z, slot * SmokeBrickCells + SmokeBrickOffset(x, y, z));
+            }
+        }, 1);
+    }
+
+    void SmokeSimulation3D::advect(float dt) {
+        density0 = density;
+        u0 = u;
+        v0 = v;
+        w0 = w;
+
+        forEachInterior([&](int x, int y, int z, size_t i) {
+            const float px = x - u[i] * dt;
+            const float py = y - v[i] * dt;
+            const float pz = z - w[i] * dt;
+
+            density0[i] = sample(density, px, py, pz);
+            u0[i] = sample(u, px, py, pz);
+            v0[i] = sample(v, px, py, pz);
+            w0[i] = sample(w, px, py, pz);
+        });
+
+        density.swap(density0);
+        u.swap(u0);
+        v.swap(v0);
+        w.swap(w0);
+    }
+
+    void SmokeSimulation3D::diffuse(float dt) {
+        const float a = diffusion * dt;
+        if (a <= 0.0f) return;
+
+        // density0 holds the source term; density and w0 ping-pong.
+        density0 = density;
+        w0 = density;
+        std::vector<float>* current = &density;
+        std::vector<float>* next = &w0;
+
+        for (int k = 0; k < iterations; ++k) {
+            const std::vector<float>& x0 = *current;
+            std::vector<float>& x1 = *next;
+
+            forEachInterior([&](int x, int y, int z, size_t i) {
+                const Stencil s = stencil(x, y, z, i);
+                x1[s.c] = (density0[s.c] + a * (x0[s.xm] + x0[s.xp] + x0[s.ym] + x0[s.yp] + x0[s.zm] + x0[s.zp])) / (1 + 6 * a);
+            });
+
+            std::swap(current, next);
+        }
+
+        if (current != &density) density.swap(*current);
+    }
+
+    void SmokeSimulation3D::project() {
+        // u0 = divergence; v0 / w0 ping-pong the pressure. Boundary pressure stays 0.
+        std::vector<float>& div = u0;
+        std::fill(div.begin(), div.end(), 0.0f);
+        std::fill(v0.begin(), v0.end(), 0.0f);
+        std::fill(w0.begin(), w0.end(), 0.0f);
+
+        forEachInterior([&](int x, int y, int z, size_t i) {
+            const Stencil s = stencil(x, y, z, i);
+            div[s.c] = -0.5f * (u[s.xp] - u[s.xm] + v[s.yp] - v[s.ym] + w[s.zp] - w[s.zm]);
+        });
+
+        std::vector<float>* current = &v0;
+        std::vector<float>* next = &w0;
+
+        for (int k = 0; k < iterations; ++k) {
+            const std::vector<float>& p0 = *current;
+            std::vector<float>& p1 = *next;
+
+            forEachInterior([&](int x, int y, int z, size_t i) {
+                const Stencil s = stencil(x, y, z, i);
+                p1[s.c] = (div[s.c] + p0[s.xm] + p0[s.xp] + p0[s.ym] + p0[s.yp] + p0[s.zm] + p0[s.zp]) / 6.0f;
+            });
+
+            std::swap(current, next);
+        }
+
+        const std::vector<float>& p = *current;
+        forEachInterior([&](int x, int y, int z, size_t i) {
+            const Stencil s = stencil(x, y, z, i);
+            u[s.c] -= 0.5f * (p[s.xp] - p[s.xm]);
+            v[s.c] -= 0.5f * (p[s.yp] - p[s.ym]);
+            w[s.c] -= 0.5f * (p[s.zp] - p[s.zm]);
+        });
+    }
+
+    void SmokeSimulation3D::update(float dt) {
+        advect(dt);
+        diffuse(dt);
+        project();
+    }
+
+} // namespace QP
@@ -0,0 +1,87 @@
+/// 3D smoke simulation on a bricked voxel grid.
+///
+/// Fields are stored in 8x8x8 bricks of contiguous memory, and the bricks
+/// themselves are laid out along a Morton (Z-order) curve, so the 7-point
+/// stencils in diffusion and projection touch at most a few neighboring bricks
+/// that are usually close in memory. Every pass runs in parallel over bricks
+/// and uses Jacobi iteration, so results do not depend on the thread count.
+
+#pragma once
+
+#include "Vector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace QP {
+
+    /// Bricks are 2^SmokeBrickShift cells along each axis.
+    constexpr int SmokeBrickShift = 3;
+    constexpr int SmokeBrickSize = 1 << SmokeBrickShift;
+    constexpr int SmokeBrickMask = SmokeBrickSize - 1;
+    constexpr int SmokeBrickCells = SmokeBrickSize * SmokeBrickSize * SmokeBrickSize;
+
+    /// Offset of a cell inside its brick, x fastest.
+    constexpr size_t SmokeBrickOffset(int x, int y, int z) {
+        return static_cast<size_t>(((z & SmokeBrickMask) << (2 * SmokeBrickShift)) |
+            ((y & SmokeBrickMask) << SmokeBrickShift) | (x & SmokeBrickMask));
+    }
+
+    class SmokeSimulation3D {
+    public:
+        /// Dimensions are rounded up to a multiple of SmokeBrickSize.
+        SmokeSimulation3D(int width, int height, int depth);
+
+        void addSmoke(int x, int y, int z, float amount);
+        void addVelocity(int x, int y, int z, const Vec3& velocity);
+
+        void update(float dt);
+
+        float smokeAt(int x, int y, int z) const { return density[index(x, y, z)]; }
+        Vec3 velocityAt(int x, int y, int z) const;
+
+        /// Storage offset of a cell: Morton-ordered brick slot, then x-fastest inside the brick.
+        size_t index(int x, int y, int z) const {
+            const size_t brick = brickSlot[(static_cast<size_t>(z >> SmokeBrickShift) * bricksY + (y >> SmokeBrickShift)) * bricksX
+                + (x >> SmokeBrickShift)];
+            return brick * SmokeBrickCells + SmokeBrickOffset(x, y, z);
+        }
+
+        bool contains(int x, int y, int z) const {
+            return x >= 0 && x < width && y >= 0 && y < height && z >= 0 && z < depth;
+        }
+
+    public:
+        int width, height, depth;
+        float diffusion{0.0001f};
+        int iterations{20};
+
+        std::vector<float> density;
+        std::vector<float> u, v, w;
+
+    private:
+        struct Stencil {
+            size_t c, xm, xp, ym, yp, zm, zp;
+        };
+
+        Stencil stencil(int x, int y, int z, size_t c) const;
+        float sample(const std::vector<float>& field, float x, float y, float z) const;
+
+        /// Calls fn(x, y, z, index) for every interior cell, in parallel over bricks.
+        template<typename F>
+        void forEachInterior(F&& fn) const;
+
+        void advect(float dt);
+        void diffuse(float dt);
+        void project();
+
+        int bricksX, bricksY, bricksZ;
+        std::vector<uint32_t> brickSlot;           ///< linear brick coordinate -> storage slot
+        std::vector<uint32_t> slotOrigin;          ///< storage slot -> packed brick coordinate
+
+        // Scratch fields, reused across passes within a step.
+        std::vector<float> density0, u0, v0, w0;
+    };
+
+} // namespace QP
@@ -0,0 +1,472 @@
+#include "Snapshot.h"
+
+#include "Cloth.h"
+#include "Fluid.h"
+#include "Gravity.h"
+#include "Rope.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <iterator>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace QP {
+
+    static const char SnapshotMagic[8] = { 'Q', 'P', 'S', 'N', 'A', 'P', 0, 0 };
+
+    static uint64_t AlignUp(uint64_t value) {
+        return (value + SnapshotAlignment - 1) & ~static_cast<uint64_t>(SnapshotAlignment - 1);
+    }
+
+    /// Temporary name unique to this write, so overlapping writes to one path
+    /// (from this or another process) never share a file.
+    static std::string TempPath(const std::string& path) {
+        static std::atomic<uint64_t> counter{0};
+#ifdef _WIN32
+        const long pid = static_cast<long>(::_getpid());
+#else
+        const long pid = static_cast<long>(::getpid());
+#endif
+        return path + ".tmp." + std::to_string(pid) + "." + std::to_string(counter.fetch_add(1));
+    }
+
+    void* SnapshotWriter::addSection(const std::string& name, SnapshotType type, size_t elementSize, size_t count) {
+        Pending pending;
+        std::memset(&pending.desc, 0, sizeof(SnapshotSection));
+        std::strncpy(pending.desc.name, name.c_str(), sizeof(pending.desc.name) - 1);
+        pending.desc.type = type;
+        pending.desc.elementSize = static_cast<uint32_t>(elementSize);
+        pending.desc.count = count;
+        pending.desc.byteSize = static_cast<uint64_t>(elementSize) * count;
+        pending.bytes.resize(elementSize * count);
+
+        sections.push_back(std::move(pending));
+        return sections.back().bytes.data();
+    }
+
+    bool SnapshotWriter::write(const std::string& path) const {
+        return writeSections(path, sections);
+    }
+
+    std::future<bool> SnapshotWriter::writeAsync(const std::string& path) {
+        std::vector<Pending> captured = std::move(sections);
+        sections.clear();
+
+        return std::async(std::launch::async, [path, captured = std::move(captured)]() {
+            return writeSections(path, captured);
+        });
+    }
+
+    void SnapshotWriter::clear() {
+        sections.clear();
+    }
+
+    bool SnapshotWriter::writeSections(const std::string& path, const std::vector<Pending>& sections) {
+        std::vector<SnapshotSection> table;
+        table.reserve(sections.size());
+
+        uint64_t offset = AlignUp(sizeof(SnapshotHeader) + sections.size() * sizeof(SnapshotSection));
+        for (const auto& pending : sections) {
+            SnapshotSection desc = pending.desc;
+            desc.offset = offset;
+            table.push_back(desc);
+            offset = AlignUp(offset + desc.byteSize);
+        }
+
+        SnapshotHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+        header.version = SnapshotVersion;
+        header.sectionCount = static_cast<uint32_t>(sections.size());
+        header.fileSize = offset;
+
+        // Write to a temporary name first so a crash mid-write never clobbers the last good checkpoint.
+        const std::string tempPath = TempPath(path);
+        auto fail = [&]() {
+            std::remove(tempPath.c_str());
+            return false;
+        };
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out) return fail();
+
+            static const char padding[SnapshotAlignment] = {};
+            uint64_t written = 0;
+            auto pad = [&](uint64_t target) {
+                out.write(padding, static_cast<std::streamsize>(target - written));
+                written = target;
+            };
+
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(SnapshotSection));
+            written = sizeof(header) + table.size() * sizeof(SnapshotSection);
+
+            for (size_t i = 0; i < sections.size(); ++i) {
+                pad(table[i].offset);
+                out.write(reinterpret_cast<const char*>(sections[i].bytes.data()), sections[i].bytes.size());
+                written += sections[i].bytes.size();
+            }
+            pad(header.fileSize);
+
+            out.flush();
+            if (!out) return fail();
+        }
+
+#ifdef _WIN32
+        // rename() does not replace an existing file on Windows.
+        std::remove(path.c_str());
+#else
+        // Make the data durable before the rename publishes it; rename itself
+        // replaces the old checkpoint atomically.
+        const int fd = ::open(tempPath.c_str(), O_WRONLY);
+        if (fd < 0) return fail();
+        const bool synced = ::fsync(fd) == 0;
+        ::close(fd);
+        if (!synced) return fail();
+#endif
+        if (std::rename(tempPath.c_str(), path.c_str()) != 0) return fail();
+        return true;
+    }
+
+    SnapshotReader::~SnapshotReader() {
+        close();
+    }
+
+    bool SnapshotReader::open(const std::string& path) {
+        close();
+
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data = buffer.data();
+        size = buffer.size();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(SnapshotHeader))) {
+            ::close(fd);
+            return false;
+        }
+
+        void* mapped = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+
+        data = static_cast<const uint8_t*>(mapped);
+        size = static_cast<size_t>(st.st_size);
+#endif
+
+        if (size < sizeof(SnapshotHeader)) {
+            close();
+            return false;
+        }
+
+        const SnapshotHeader& hdr = header();
+        if (std::memcmp(hdr.magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0 ||
+            hdr.version != SnapshotVersion || hdr.fileSize > size ||
+            sizeof(SnapshotHeader) + static_cast<uint64_t>(hdr.sectionCount) * sizeof(SnapshotSection) > size) {
+            close();
+            return false;
+        }
+
+        const SnapshotSection* table = reinterpret_cast<const SnapshotSection*>(data + sizeof(SnapshotHeader));
+        for (uint32_t i = 0; i < hdr.sectionCount; ++i) {
+            const SnapshotSection& section = table[i];
+            // Compare by division so corrupt sizes cannot overflow their way past the checks.
+            const bool sizeMatches = section.elementSize == 0
+                ? section.byteSize == 0 && section.count == 0
+                : section.byteSize % section.elementSize == 0 && section.byteSize / section.elementSize == section.count;
+            if (section.offset % SnapshotAlignment != 0 || section.offset > size ||
+                section.byteSize > size - section.offset || !sizeMatches) {
+                close();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void SnapshotReader::close() {
+#ifdef _WIN32
+        buffer.clear();
+        buffer.shrink_to_fit();
+#else
+        if (data) ::munmap(const_cast<uint8_t*>(data), size);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    const SnapshotSection* SnapshotReader::find(const std::string& name) const {
+        if (!data) return nullptr;
+
+        const SnapshotSection* table = reinterpret_cast<const SnapshotSection*>(data + sizeof(SnapshotHeader));
+        for (uint32_t i = 0; i < header().sectionCount; ++i) {
+            if (std::strncmp(table[i].name, name.c_str(), sizeof(table[i].name)) == 0)
+                return &table[i];
+        }
+        return nullptr;
+    }
+
+
+    static void WriteVec3(float* out, const Vec3& v) {
+        out[0] = v.x;
+        out[1] = v.y;
+        out[2] = v.z;
+    }
+
+    static void WriteVec2(float* out, const Vec2& v) {
+        out[0] = v.x;
+        out[1] = v.y;
+    }
+
+    void CaptureSnapshot(SnapshotWriter& writer, const Gravity& sim, const std::string& prefix) {
+        const auto& particles = sim.particles;
+        const size_t n = particles.size();
+
+        float* position = writer.addSection<float>(prefix + ".position", SnapshotType::Float32, n * 3);
+        float* velocity = writer.addSection<float>(prefix + ".velocity", SnapshotType::Float32, n * 3);
+        float* acceleration = writer.addSection<float>(prefix + ".acceleration", SnapshotType::Float32, n * 3);
+        float* mass = writer.addSection<float>(prefix + ".mass", SnapshotType::Float32, n);
+
+        for (size_t i = 0; i < n; ++i) {
+            WriteVec3(position + i * 3, particles[i].position);
+            WriteVec3(velocity + i * 3, particles[i].velocity);
+            WriteVec3(acceleration + i * 3, particles[i].acceleration);
+            mass[i] = particles[i].mass;
+        }
+    }
+
+    bool RestoreSnapshot(const SnapshotReader& reader, Gravity& sim, const std::string& prefix) {
+        size_t positionCount, velocityCount, accelerationCount, massCount;
+        const float* position = reader.view<float>(prefix + ".position", positionCount);
+        const float* velocity = reader.view<float>(prefix + ".velocity", velocityCount);
+        const float* acceleration = reader.view<float>(prefix + ".acceleration", accelerationCount);
+        const float* mass = reader.view<float>(prefix + ".mass", massCount);
+
+        if (!position || !velocity || !acceleration || !mass) return false;
+        if (positionCount != massCount * 3 || velocityCount != massCount * 3 || accelerationCount != massCount * 3)
+            return false;
+
+        sim.particles.resize(massCount);
+        for (size_t i = 0; i < massCount; ++i) {
+            GravityParticle& p = sim.particles[i];
+            p.position = { position[i * 3], position[i * 3 + 1], position[i * 3 + 2] };
+            p.velocity = { velocity[i * 3], velocity[i * 3 + 1], velocity[i * 3 + 2] };
+            p.acceleration = { acceleration[i * 3], acceleration[i * 3 + 1], acceleration[i * 3 + 2] };
+            p.mass = mass[i];
+        }
+        return true;
+    }
+
+    void CaptureSnapshot(SnapshotWriter& writer, const FluidSimulation& sim, const std::string& prefix) {
+        const size_t n = static_cast<size_t>(sim.width) * sim.height;
+
+        int32_t* dims = writer.addSection<int32_t>(prefix + ".dims", SnapshotType::Int32, 2);
+        dims[0] = sim.width;
+        dims[1] = sim.height;
+
+        float* pressure = writer.addSection<float>(prefix + ".pressure", SnapshotType::Float32, n);
+        float* smoke = writer.addSection<float>(prefix + ".smoke", SnapshotType::Float32, n);
+        float* u = writer.addSection<float>(prefix + ".u", SnapshotType::Float32, n);
+        float* v = writer.addSection<float>(prefix + ".v", SnapshotType::Float32, n);
+        uint8_t* obstacle = writer.addSection<uint8_t>(prefix + ".obstacle", SnapshotType::UInt8, n);
+
+        // Column-major, matching grid[x][y].
+        size_t i = 0;
+        for (int x = 0; x < sim.width; ++x) {
+            for (int y = 0; y < sim.height; ++y, ++i) {
+                const FluidCell& cell = sim.grid[x][y];
+                pressure[i] = cell.pressure;
+                smoke[i] = cell.smoke;
+                u[i] = cell.velocity.u;
+                v[i] = cell.velocity.v;
+                obstacle[i] = cell.obstacle ? 1 : 0;
+            }
+        }
+    }
+
+    bool RestoreSnapshot(const SnapshotReader& reader, FluidSimulation& sim, const std::string& prefix) {
+        size_t dimsCount, pressureCount, smokeCount, uCount, vCount, obstacleCount;
+        const int32_t* dims = reader.view<int32_t>(prefix + ".dims", dimsCount);
+        const float* pressure = reader.view<float>(prefix + ".pressure", pressureCount);
+        const float* smoke = reader.view<float>(prefix + ".smoke", smokeCount);
+        const float* u = reader.view<float>(prefix + ".u", uCount);
+        const float* v = reader.view<float>(prefix + ".v", vCount);
+        const uint8_t* obstacle = reader.view<uint8_t>(prefix + ".obstacle", obstacleCount);
+
+        if (!dims || dimsCount != 2 || !pressure || !smoke || !u || !v || !obstacle) return false;
+        if (dims[0] <= 0 || dims[1] <= 0) return false;
+
+        const size_t n = static_cast<size_t>(dims[0]) * dims[1];
+        if (pressureCount != n || smokeCount != n || uCount != n || vCount != n || obstacleCount != n)
+            return false;
+
+        sim.width = dims[0];
+        sim.height = dims[1];
+        sim.grid.assign(sim.width, std::vector<FluidCell>(sim.height));
+
+        size_t i = 0;
+        for (int x = 0; x < sim.width; ++x) {
+            for (int y = 0; y < sim.height; ++y, ++i) {
+                sim.grid[x][y] = { pressure[i], smoke[i], { u[i], v[i] }, obstacle[i] != 0 };
+            }
+        }
+        sim.invalidateObstacles();
+        return true;
+    }
+
+    void CaptureSnapshot(SnapshotWriter& writer, const Cloth& cloth, const std::string& prefix) {
+        const size_t n = cloth.particles.size();
+        const size_t m = cloth.constraints.size();
+
+        int32_t* dims = writer.addSection<int32_t>(prefix + ".dims", SnapshotType::Int32, 2);
+        dims[0] = static_cast<int32_t>(cloth.width);
+        dims[1] = static_cast<int32_t>(cloth.height);
+
+        float* position = writer.addSection<float>(prefix + ".position", SnapshotType::Float32, n * 2);
+        float* oldPosition = writer.addSection<float>(prefix + ".oldPosition", SnapshotType::Float32, n * 2);
+        float* acceleration = writer.addSection<float>(prefix + ".acceleration", SnapshotType::Float32, n * 2);
+        uint8_t* isStatic = writer.addSection<uint8_t>(prefix + ".static", SnapshotType::UInt8, n);
+        int32_t* constraints = writer.addSection<int32_t>(prefix + ".constraints", SnapshotType::Int32, m * 2);
+
+        for (size_t i = 0; i < n; ++i) {
+            const Particle& p = cloth.particles[i];
+            WriteVec2(position + i * 2, p.position);
+            WriteVec2(oldPosition + i * 2, p.oldPosition);
+            WriteVec2(acceleration + i * 2, p.acceleration);
+            isStatic[i] = p.isStatic ? 1 : 0;
+        }
+
+        for (size_t i = 0; i < m; ++i) {
+            constraints[i * 2] = cloth.constraints[i].first;
+            constraints[i * 2 + 1] = cloth.constraints[i].second;
+        }
+    }
+
+    bool RestoreSnapshot(const SnapshotReader& reader, Cloth& cloth, const std::string& prefix) {
+        size_t dimsCount, positionCount, oldPositionCount, accelerationCount, staticCount, constraintCount;
+        const int32_t* dims = reader.view<int32_t>(prefix + ".dims", dimsCount);
+        const float* position = reader.view<float>(prefix + ".position", positionCount);
+        const float* oldPosition = reader.view<float>(prefix + ".oldPosition", oldPositionCount);
+        const float* acceleration = reader.view<float>(prefix + ".acceleration", accelerationCount);
+        const uint8_t* isStatic = reader.view<uint8_t>(prefix + ".static", staticCount);
+        const int32_t* constraints = reader.view<int32_t>(prefix + ".constraints", constraintCount);
+
+        if (!dims || dimsCount != 2 || !position || !oldPosition || !acceleration || !isStatic || !constraints)
+            return false;
+
+        const size_t n = staticCount;
+        if (positionCount != n * 2 || oldPositionCount != n * 2 || accelerationCount != n * 2 || constraintCount % 2 != 0)
+            return false;
+
+        if (dims[0] < 0 || dims[1] < 0 || static_cast<uint64_t>(dims[0]) * static_cast<uint64_t>(dims[1]) != n)
+            return false;
+
+        for (size_t i = 0; i < constraintCount; ++i) {
+            if (constraints[i] < 0 || static_cast<size_t>(constraints[i]) >= n) return false;
+        }
+
+        cloth.width = static_cast<size_t>(dims[0]);
+        cloth.height = static_cast<size_t>(dims[1]);
+
+        cloth.particles.clear();
+        cloth.particles.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            cloth.particles.emplace_back(position[i * 2], position[i * 2 + 1]);
+            Particle& p = cloth.particles.back();
+            p.oldPosition = { oldPosition[i * 2], oldPosition[i * 2 + 1] };
+            p.acceleration = { acceleration[i * 2], acceleration[i * 2 + 1] };
+            p.isStatic = isStatic[i] != 0;
+        }
+
+        cloth.constraints.clear();
+        cloth.constraints.reserve(constraintCount / 2);
+        for (size_t i = 0; i < constraintCount; i += 2) {
+            cloth.constraints.emplace_back(constraints[i], constraints[i + 1]);
+        }
+
+        cloth.buildIslands();
+        return true;
+    }
+
+    void CaptureSnapshot(SnapshotWriter& writer, const Rope& rope, const std::string& prefix) {
+        const size_t n = rope.particles.size();
+        const size_t m = rope.constraints.size();
+
+        float* position = writer.addSection<float>(prefix + ".position", SnapshotType::Float32, n * 2);
+        float* prevPosition = writer.addSection<float>(prefix + ".prevPosition", SnapshotType::Float32, n * 2);
+        float* acceleration = writer.addSection<float>(prefix + ".acceleration", SnapshotType::Float32, n * 2);
+        int32_t* constraints = writer.addSection<int32_t>(prefix + ".constraints", SnapshotType::Int32, m * 2);
+        float* restLength = writer.addSection<float>(prefix + ".restLength", SnapshotType::Float32, m);
+
+        for (size_t i = 0; i < n; ++i) {
+            const RopeParticle& p = rope.particles[i];
+            WriteVec2(position + i * 2, p.position);
+            WriteVec2(prevPosition + i * 2, p.prevPosition);
+            WriteVec2(acceleration + i * 2, p.acceleration);
+        }
+
+        // Constraints hold raw pointers; store them as particle indices.
+        const RopeParticle* base = rope.particles.data();
+        for (size_t i = 0; i < m; ++i) {
+            constraints[i * 2] = static_cast<int32_t>(rope.constraints[i].p1 - base);
+            constraints[i * 2 + 1] = static_cast<int32_t>(rope.constraints[i].p2 - base);
+            restLength[i] = rope.constraints[i].restLength;
+        }
+    }
+
+    bool RestoreSnapshot(const SnapshotReader& reader, Rope& rope, const std::string& prefix) {
+        size_t positionCount, prevPositionCount, accelerationCount, constraintCount, restLengthCount;
+        const float* position = reader.view<float>(prefix + ".position", positionCount);
+        const float* prevPosition = reader.view<float>(prefix + ".prevPosition", prevPositionCount);
+        const float* acceleration = reader.view<float>(prefix + ".acceleration", accelerationCount);
+        const int32_t* constraints = reader.view<int32_t>(prefix + ".constraints", constraintCount);
+        const float* restLength = reader.view<float>(prefix + ".restLength", restLengthCount);
+
+        if (!position || !prevPosition || !acceleration || !constraints || !restLength) return false;
+
+        const size_t n = positionCount / 2;
+        if (positionCount % 2 != 0 || prevPositionCount != n * 2 || accelerationCount != n * 2 ||
+            constraintCount != restLengthCount * 2)
+            return false;
+
+        for (size_t i = 0; i < constraintCount; ++i) {
+            if (constraints[i] < 0 || static_cast<size_t>(constraints[i]) >= n) return false;
+        }
+
+        rope.particles.clear();
+        rope.particles.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            rope.particles.emplace_back(Vec2(position[i * 2], position[i * 2 + 1]));
+            RopeParticle& p = rope.particles.back();
+            p.prevPosition = { prevPosition[i * 2], prevPosition[i * 2 + 1] };
+            p.acceleration = { acceleration[i * 2], acceleration[i * 2 + 1] };
+        }
+
+        rope.constraints.clear();
+        rope.constraints.reserve(restLengthCount);
+        for (size_t i = 0; i < restLengthCount; ++i) {
+            rope.constraints.emplace_back(&rope.particles[constraints[i * 2]], &rope.particles[constraints[i * 2 + 1]]);
+            rope.constraints.back().restLength = restLength[i];
+        }
+
+        // The rest counters describe the replaced state; let the rope settle again.
+        rope.wake();
+        return true;
+    }
+
+} // namespace QP
@@ -0,0 +1,133 @@
+/// Versioned binary checkpoint format for simulation state.
+///
+/// Layout (little-endian, native float):
+///   SnapshotHeader | SnapshotSection[sectionCount] | section data...
+/// Every section's data starts on a SnapshotAlignment boundary, so a mapped
+/// file can be viewed in place as typed arrays without any parsing.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace QP {
+
+    class Cloth;
+    class FluidSimulation;
+    class Rope;
+    struct Gravity;
+
+    constexpr uint32_t SnapshotVersion = 1;
+    constexpr size_t SnapshotAlignment = 64;
+
+    enum class SnapshotType : uint32_t {
+        Float32 = 0,
+        Float64 = 1,
+        Int32 = 2,
+        UInt8 = 3
+    };
+
+    struct SnapshotHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t sectionCount;
+        uint64_t fileSize;
+        uint64_t reserved;
+    };
+
+    struct SnapshotSection {
+        char name[32];
+        SnapshotType type;
+        uint32_t elementSize;
+        uint64_t count;
+        uint64_t offset;
+        uint64_t byteSize;
+    };
+
+    static_assert(sizeof(SnapshotHeader) == 32, "SnapshotHeader layout changed");
+    static_assert(sizeof(SnapshotSection) == 64, "SnapshotSection layout changed");
+
+    class SnapshotWriter {
+    public:
+        /// Reserves a section and returns its storage for the caller to fill.
+        void* addSection(const std::string& name, SnapshotType type, size_t elementSize, size_t count);
+
+        template<typename T>
+        T* addSection(const std::string& name, SnapshotType type, size_t count) {
+            return static_cast<T*>(addSection(name, type, sizeof(T), count));
+        }
+
+        bool write(const std::string& path) const;
+
+        /// Hands the captured sections to a background thread and returns immediately.
+        /// The writer is left empty. Keep the future alive until the write is done:
+        /// destroying it blocks until the file has been written. Overlapping writes
+        /// to one path are safe; the file ends up as whichever finished last.
+        std::future<bool> writeAsync(const std::string& path);
+
+        void clear();
+
+    private:
+        struct Pending {
+            SnapshotSection desc;
+            std::vector<uint8_t> bytes;
+        };
+
+        static bool writeSections(const std::string& path, const std::vector<Pending>& sections);
+
+        std::vector<Pending> sections;
+    };
+
+    class SnapshotReader {
+    public:
+        SnapshotReader() = default;
+        ~SnapshotReader();
+
+        SnapshotReader(const SnapshotReader&) = delete;
+        SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+        /// Maps the file read-only and validates header and section table.
+        bool open(const std::string& path);
+        void close();
+
+        bool isOpen() const { return data != nullptr; }
+        const SnapshotHeader& header() const { return *reinterpret_cast<const SnapshotHeader*>(data); }
+
+        const SnapshotSection* find(const std::string& name) const;
+
+        /// Zero-copy view into the mapped file. Returns nullptr if the section is
+        /// missing or its element size does not match T.
+        template<typename T>
+        const T* view(const std::string& name, size_t& count) const {
+            const SnapshotSection* section = find(name);
+            if (!section || section->elementSize != sizeof(T)) {
+                count = 0;
+                return nullptr;
+            }
+            count = static_cast<size_t>(section->count);
+            return reinterpret_cast<const T*>(data + section->offset);
+        }
+
+    private:
+        const uint8_t* data{nullptr};
+        size_t size{0};
+#ifdef _WIN32
+        std::vector<uint8_t> buffer;
+#endif
+    };
+
+    /// Captures copy the state into the writer synchronously; only the file I/O is deferred.
+    void CaptureSnapshot(SnapshotWriter& writer, const Gravity& sim, const std::string& prefix = "gravity");
+    void CaptureSnapshot(SnapshotWriter& writer, const FluidSimulation& sim, const std::string& prefix = "fluid");
+    void CaptureSnapshot(SnapshotWriter& writer, const Cloth& cloth, const std::string& prefix = "cloth");
+    void CaptureSnapshot(SnapshotWriter& writer, const Rope& rope, const std::string& prefix = "rope");
+
+    bool RestoreSnapshot(const SnapshotReader& reader, Gravity& sim, const std::string& prefix = "gravity");
+    bool RestoreSnapshot(const SnapshotReader& reader, FluidSimulation& sim, const std::string& prefix = "fluid");
+    bool RestoreSnapshot(const SnapshotReader& reader, Cloth& cloth, const std::string& prefix = "cloth");
+    bool RestoreSnapshot(const SnapshotReader& reader, Rope& rope, const std::string& prefix = "rope");
+
+} // namespace QP
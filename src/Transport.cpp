@@ -0,0 +1,208 @@
+#include "Transport.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace QP {
+
+    namespace {
+
+        // Collective tags live above the range handed out to solvers.
+        constexpr uint32_t TagReduceUp = 0xFFFF0001;
+        constexpr uint32_t TagReduceDown = 0xFFFF0002;
+
+        struct MessageHeader {
+            uint32_t tag;
+            uint32_t bytes;
+        };
+
+    }
+
+    bool AllReduceMax(Transport& transport, float& value) {
+        const int size = transport.size();
+        if (size <= 1) return true;
+
+        if (transport.rank() == 0) {
+            // Answer every rank even after a failure so none of them waits forever.
+            bool ok = true;
+            for (int r = 1; r < size; ++r) {
+                float other = value;
+                if (transport.recv(r, TagReduceUp, &other, sizeof(other)))
+                    value = std::max(value, other);
+                else
+                    ok = false;
+            }
+            for (int r = 1; r < size; ++r)
+                transport.send(r, TagReduceDown, &value, sizeof(value));
+            return ok;
+        }
+
+        transport.send(0, TagReduceUp, &value, sizeof(value));
+        return transport.recv(0, TagReduceDown, &value, sizeof(value));
+    }
+
+#ifndef _WIN32
+
+    static bool WriteAll(int fd, const uint8_t* data, size_t bytes) {
+        while (bytes > 0) {
+            const ssize_t n = ::send(fd, data, bytes, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            bytes -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    static bool ReadAll(int fd, uint8_t* data, size_t bytes) {
+        while (bytes > 0) {
+            const ssize_t n = ::read(fd, data, bytes);
+            if (n == 0) return false;
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            bytes -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    SocketTransport::SocketTransport(int rank, std::vector<int> fds)
+        : self(rank), peers(std::move(fds)) {
+        // Started here rather than lazily: a transport is always constructed in
+        // the process that uses it, after any fork.
+        sender = std::thread(&SocketTransport::senderLoop, this);
+    }
+
+    SocketTransport::~SocketTransport() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        pending.notify_one();
+        sender.join();
+
+        for (int fd : peers)
+            if (fd >= 0) ::close(fd);
+    }
+
+    void SocketTransport::send(int dest, uint32_t tag, const void* data, size_t bytes) {
+        Message message;
+        message.fd = peers[dest];
+        message.bytes.resize(sizeof(MessageHeader) + bytes);
+
+        const MessageHeader header{ tag, static_cast<uint32_t>(bytes) };
+        std::memcpy(message.bytes.data(), &header, sizeof(header));
+        if (bytes > 0) std::memcpy(message.bytes.data() + sizeof(header), data, bytes);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(message));
+        }
+        pending.notify_one();
+    }
+
+    bool SocketTransport::recv(int source, uint32_t tag, void* data, size_t bytes) {
+        const int fd = peers[source];
+        MessageHeader header;
+        if (!ReadAll(fd, reinterpret_cast<uint8_t*>(&header), sizeof(header))) return false;
+
+        if (header.tag != tag || header.bytes != bytes) {
+            // Skip the payload so the stream stays aligned on message boundaries.
+            uint8_t scratch[4096];
+            for (size_t left = header.bytes; left > 0;) {
+                const size_t chunk = std::min(left, sizeof(scratch));
+                if (!ReadAll(fd, scratch, chunk)) break;
+                left -= chunk;
+            }
+            return false;
+        }
+        return ReadAll(fd, static_cast<uint8_t*>(data), bytes);
+    }
+
+    void SocketTransport::senderLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            pending.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) return; // stopping, and everything has been flushed
+
+            Message message = std::move(queue.front());
+            queue.pop_front();
+
+            lock.unlock();
+            WriteAll(message.fd, message.bytes.data(), message.bytes.size());
+            lock.lock();
+        }
+    }
+
+    std::vector<std::vector<int>> SocketTransport::CreateMesh(int size) {
+        std::vector<std::vector<int>> fds(size, std::vector<int>(size, -1));
+        for (int a = 0; a < size; ++a) {
+            for (int b = a + 1; b < size; ++b) {
+                int pair[2];
+                if (::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+                    for (auto& row : fds)
+                        for (int fd : row)
+                            if (fd >= 0) ::close(fd);
+                    return {};
+                }
+                fds[a][b] = pair[0];
+                fds[b][a] = pair[1];
+            }
+        }
+        return fds;
+    }
+
+    std::vector<std::unique_ptr<SocketTransport>> SocketTransport::CreateGroup(int size) {
+        std::vector<std::unique_ptr<SocketTransport>> group;
+        std::vector<std::vector<int>> fds = CreateMesh(size);
+        if (fds.empty()) return group;
+
+        for (int r = 0; r < size; ++r)
+            group.push_back(std::make_unique<SocketTransport>(r, std::move(fds[r])));
+        return group;
+    }
+
+    std::unique_ptr<SocketTransport> SocketTransport::Spawn(int size) {
+        std::vector<std::vector<int>> fds = CreateMesh(size);
+        if (fds.empty()) return nullptr;
+
+        int rank = 0;
+        for (int r = 1; r < size; ++r) {
+            const pid_t pid = ::fork();
+            if (pid < 0) {
+                // Drop every end we hold, so the children already forked read EOF
+                // from rank 0 and the unborn ranks instead of blocking.
+                for (auto& row : fds)
+                    for (int fd : row)
+                        if (fd >= 0) ::close(fd);
+                return nullptr;
+            }
+            if (pid == 0) {
+                rank = r;
+                break;
+            }
+        }
+
+        // Keep only this rank's ends of the mesh.
+        for (int r = 0; r < size; ++r) {
+            if (r == rank) continue;
+            for (int fd : fds[r])
+                if (fd >= 0) ::close(fd);
+        }
+        return std::make_unique<SocketTransport>(rank, std::move(fds[rank]));
+    }
+
+#endif
+
+} // namespace QP
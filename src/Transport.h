@@ -0,0 +1,87 @@
+/// Point-to-point message transport between cooperating solver ranks.
+///
+/// send() never blocks on the receiver: the message is copied and delivered
+/// in the background, so callers can post halo data and keep computing.
+/// Messages between one pair of ranks arrive in the order they were sent.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace QP {
+
+    class Transport {
+    public:
+        virtual ~Transport() = default;
+
+        virtual int rank() const = 0;
+        virtual int size() const = 0;
+
+        virtual void send(int dest, uint32_t tag, const void* data, size_t bytes) = 0;
+
+        /// Blocks until the next message from source arrives. Returns false if
+        /// the peer is gone or the message does not match tag and size; a
+        /// mismatched message is consumed, so the next recv sees the one after it.
+        virtual bool recv(int source, uint32_t tag, void* data, size_t bytes) = 0;
+    };
+
+    /// Max over all ranks; every rank gets the result in value. Returns false
+    /// if a contribution or the result could not be received.
+    bool AllReduceMax(Transport& transport, float& value);
+
+#ifndef _WIN32
+
+    /// Transport over Unix domain socket pairs, one per pair of ranks. Works
+    /// between threads of one process or between forked processes.
+    class SocketTransport : public Transport {
+    public:
+        /// fds[peer] is this rank's end of the socket shared with peer (-1 for itself).
+        SocketTransport(int rank, std::vector<int> fds);
+        ~SocketTransport() override;
+
+        SocketTransport(const SocketTransport&) = delete;
+        SocketTransport& operator=(const SocketTransport&) = delete;
+
+        int rank() const override { return self; }
+        int size() const override { return static_cast<int>(peers.size()); }
+
+        void send(int dest, uint32_t tag, const void* data, size_t bytes) override;
+        bool recv(int source, uint32_t tag, void* data, size_t bytes) override;
+
+        /// Fully connected group for use from threads of this process.
+        static std::vector<std::unique_ptr<SocketTransport>> CreateGroup(int size);
+
+        /// Forks size - 1 worker processes and returns this process's endpoint:
+        /// rank 0 in the caller, 1..size-1 in the children. Returns nullptr on failure;
+        /// children forked before the failure then see their peers disconnect.
+        static std::unique_ptr<SocketTransport> Spawn(int size);
+
+    private:
+        struct Message {
+            int fd;
+            std::vector<uint8_t> bytes;
+        };
+
+        static std::vector<std::vector<int>> CreateMesh(int size);
+        void senderLoop();
+
+        int self;
+        std::vector<int> peers;
+
+        std::thread sender;
+        std::mutex mutex;
+        std::condition_variable pending;
+        std::deque<Message> queue;
+        bool stopping{false};
+    };
+
+#endif
+
+} // namespace QP
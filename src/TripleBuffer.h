@@ -0,0 +1,64 @@
+/// Lock-free triple buffer for handing completed frames from one producer
+/// (the stepping thread) to one consumer (renderer, analysis...).
+///
+/// The producer fills writeBuffer() and calls publish(); the consumer calls
+/// update() and then read(). Neither side ever blocks or sees a torn frame,
+/// and the consumer always gets the most recently published one.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace QP {
+
+    template<typename T>
+    class TripleBuffer {
+    public:
+        TripleBuffer() = default;
+
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        // Producer side
+
+        T& writeBuffer() { return slots[writeIndex].value; }
+
+        void publish() {
+            slots[writeIndex].sequence = ++published;
+            uint8_t previous = middle.exchange(static_cast<uint8_t>(writeIndex | DirtyBit), std::memory_order_acq_rel);
+            writeIndex = previous & IndexMask;
+        }
+
+        // Consumer side
+
+        /// Picks up the latest published frame, if any. Returns false when nothing new arrived.
+        bool update() {
+            if (!(middle.load(std::memory_order_relaxed) & DirtyBit)) return false;
+            uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+            readIndex = previous & IndexMask;
+            return true;
+        }
+
+        const T& read() const { return slots[readIndex].value; }
+
+        /// Publish count of the frame returned by read(); 0 before the first update().
+        uint64_t sequence() const { return slots[readIndex].sequence; }
+
+    private:
+        static constexpr uint8_t IndexMask = 0x3;
+        static constexpr uint8_t DirtyBit = 0x4;
+
+        struct Slot {
+            T value{};
+            uint64_t sequence{0};
+        };
+
+        Slot slots[3];
+        uint8_t writeIndex{0};
+        uint8_t readIndex{2};
+        std::atomic<uint8_t> middle{1};
+        uint64_t published{0};
+    };
+
+} // namespace QP
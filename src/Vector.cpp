@@ -143,5 +143,17 @@ namespace QP {
         return Vec2(x / len, y / len);
     }
 
+    void normalize(Vec2& vec) {
+        float len = vec.length();
+        if (len > 0.0f) {
+            vec.x /= len;
+            vec.y /= len;
+        }
+    }
+
+    float dot(const Vec2& a, const Vec2& b) {
+        return a.x * b.x + a.y * b.y;
+    }
+
 
 } // Namespace QP
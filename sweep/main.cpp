@@ -0,0 +1,455 @@
+#include "Cloth.h"
+#include "Fluid.h"
+#include "Gravity.h"
+#include "Parallel.h"
+#include "Pendulum.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Runs a batch of independent simulations described by a CSV spec.
+//
+// The spec has a header row. Columns id, sim, steps and dt are required; any
+// other column is a parameter of the simulation named in sim, and an empty cell
+// means the default. Lines starting with # are ignored.
+//
+//   id,sim,steps,dt,theta1,seed,count,stiffness,integrator
+//   p1,pendulum,10000,0.001,1.5,,,,
+//   g1,gravity,100,0.01,,42,500,,
+//   c1,cloth,600,0.1666,,,,5000,implicit
+//
+// Every finished run appends one line to the results file, flushed as soon as it
+// is written:
+//
+//   id,sim,status,wall_ms,metrics
+//
+// where metrics is a ;-separated list of name=value. Runs whose id already has
+// an ok line in the results file are skipped, so an interrupted sweep resumes by
+// running the same command again; error and nonfinite runs are retried, and the
+// newest line for an id is the one that counts.
+
+namespace {
+
+    const double Pi = 3.14159265358979323846;
+
+    using Row = std::map<std::string, std::string>;
+    using Metrics = std::vector<std::pair<std::string, double>>;
+
+    struct Run {
+        std::string id;
+        std::string sim;
+        long steps;
+        double dt;
+        Row params;
+
+        double number(const std::string& name, double fallback) const {
+            auto it = params.find(name);
+            if (it == params.end() || it->second.empty()) return fallback;
+            size_t used = 0;
+            const double value = std::stod(it->second, &used);
+            if (used != it->second.size()) throw std::invalid_argument("bad value for " + name);
+            return value;
+        }
+
+        /// An integer of at least minimum that fits in an int.
+        int integer(const std::string& name, int fallback, int minimum) const {
+            const double value = number(name, fallback);
+            if (!(value >= minimum) || value > std::numeric_limits<int>::max() || value != std::floor(value))
+                throw std::invalid_argument(name + " must be an integer >= " + std::to_string(minimum));
+            return static_cast<int>(value);
+        }
+
+        /// A grid dimension: an integer of at least 1.
+        int dimension(const std::string& name, int fallback) const {
+            return integer(name, fallback, 1);
+        }
+
+        std::string text(const std::string& name, const std::string& fallback) const {
+            auto it = params.find(name);
+            return it == params.end() || it->second.empty() ? fallback : it->second;
+        }
+    };
+
+    std::string Trim(const std::string& s) {
+        const size_t b = s.find_first_not_of(" \t\r");
+        if (b == std::string::npos) return "";
+        return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+    }
+
+    std::vector<std::string> SplitFields(const std::string& line) {
+        std::vector<std::string> fields;
+        std::stringstream in(line);
+        std::string field;
+        while (std::getline(in, field, ',')) fields.push_back(Trim(field));
+        if (!line.empty() && line.back() == ',') fields.emplace_back();
+        return fields;
+    }
+
+    bool LoadSpec(const std::string& path, std::vector<Run>& runs, std::string& error) {
+        std::ifstream in(path);
+        if (!in) {
+            error = "could not open " + path;
+            return false;
+        }
+
+        std::vector<std::string> header;
+        std::set<std::string> ids;
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(in, line)) {
+            ++lineNumber;
+            if (Trim(line).empty() || Trim(line)[0] == '#') continue;
+
+            std::vector<std::string> fields = SplitFields(line);
+            if (header.empty()) {
+                header = fields;
+                for (const char* required : { "id", "sim", "steps", "dt" }) {
+                    if (std::find(header.begin(), header.end(), required) == header.end()) {
+                        error = std::string("spec header is missing column ") + required;
+                        return false;
+                    }
+                }
+                continue;
+            }
+
+            if (fields.size() > header.size()) {
+                error = "line " + std::to_string(lineNumber) + " has more fields than the header";
+                return false;
+            }
+
+            Run run;
+            for (size_t i = 0; i < fields.size(); ++i) run.params[header[i]] = fields[i];
+            run.id = run.params["id"];
+            run.sim = run.params["sim"];
+
+            try {
+                run.steps = std::stol(run.params["steps"]);
+                run.dt = std::stod(run.params["dt"]);
+            } catch (const std::exception&) {
+                error = "line " + std::to_string(lineNumber) + ": steps and dt must be numbers";
+                return false;
+            }
+
+            if (run.id.empty() || !ids.insert(run.id).second) {
+                error = "line " + std::to_string(lineNumber) + ": id must be present and unique";
+                return false;
+            }
+            runs.push_back(std::move(run));
+        }
+
+        if (header.empty()) {
+            error = "spec is empty";
+            return false;
+        }
+        return true;
+    }
+
+    /// Ids whose latest line in the results file has status ok; error and
+    /// nonfinite runs are run again. A trailing line without a newline was cut
+    /// off by an interruption; it is dropped so the run is repeated.
+    bool LoadFinished(const std::string& path, std::set<std::string>& finished, std::string& error) {
+        finished.clear();
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return true;
+
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+
+        const size_t complete = contents.rfind('\n') == std::string::npos ? 0 : contents.rfind('\n') + 1;
+        if (complete < contents.size()) {
+            std::error_code code;
+            std::filesystem::resize_file(path, complete, code);
+            if (code) {
+                error = "could not truncate the partial last line of " + path + ": " + code.message();
+                return false;
+            }
+        }
+
+        std::stringstream lines(contents.substr(0, complete));
+        std::string line;
+        bool header = true;
+        while (std::getline(lines, line)) {
+            if (header) {
+                header = false;
+                continue;
+            }
+            // id,sim,status,...
+            const size_t idEnd = line.find(',');
+            const size_t simEnd = idEnd == std::string::npos ? idEnd : line.find(',', idEnd + 1);
+            const size_t statusEnd = simEnd == std::string::npos ? simEnd : line.find(',', simEnd + 1);
+            if (statusEnd == std::string::npos) continue;
+
+            const std::string id = line.substr(0, idEnd);
+            if (line.compare(simEnd + 1, statusEnd - simEnd - 1, "ok") == 0)
+                finished.insert(id);
+            else
+                finished.erase(id);
+        }
+        return true;
+    }
+
+    Metrics RunPendulum(const Run& run) {
+        const QP::Pendulum p1{ run.number("l1", 1.0), run.number("m1", 1.0) };
+        const QP::Pendulum p2{ run.number("l2", 1.0), run.number("m2", 1.0) };
+        const QP::Parameters params{ run.number("g", 9.81) };
+        QP::State state{ run.number("theta1", 1.0), run.number("theta2", 0.0),
+                         run.number("omega1", 0.0), run.number("omega2", 0.0) };
+
+        auto energy = [&](const QP::State& s) {
+            const double v1 = p1.length * s.omega1;
+            const double v2sq = v1 * v1 + p2.length * p2.length * s.omega2 * s.omega2 +
+                2 * p1.length * p2.length * s.omega1 * s.omega2 * std::cos(s.theta1 - s.theta2);
+            const double kinetic = 0.5 * p1.mass * v1 * v1 + 0.5 * p2.mass * v2sq;
+            const double y1 = -p1.length * std::cos(s.theta1);
+            const double y2 = y1 - p2.length * std::cos(s.theta2);
+            return kinetic + params.g * (p1.mass * y1 + p2.mass * y2);
+        };
+
+        const double initial = energy(state);
+        double firstFlip = -1.0;
+        for (long i = 0; i < run.steps; ++i) {
+            QP::runge_kutta_step(p1, p2, params, state, run.dt);
+            if (firstFlip < 0.0 && std::abs(state.theta2) > Pi) firstFlip = (i + 1) * run.dt;
+        }
+
+        const double current = energy(state);
+        return {
+            { "theta1", state.theta1 }, { "theta2", state.theta2 },
+            { "omega1", state.omega1 }, { "omega2", state.omega2 },
+            { "energy_drift", initial != 0.0 ? (current - initial) / std::abs(initial) : current - initial },
+            { "first_flip", firstFlip }
+        };
+    }
+
+    Metrics RunGravity(const Run& run) {
+        QP::Gravity sim;
+        const int count = run.integer("count", 1000, 1);
+        const uint64_t seed = static_cast<uint64_t>(run.number("seed", 0));
+        const std::string init = run.text("init", "uniform");
+
+        if (init == "uniform")
+            QP::InitializeParticles(sim, count, static_cast<float>(run.number("range", 100.0)), seed);
+        else if (init == "plummer")
+            QP::InitializePlummerSphere(sim, count, static_cast<float>(run.number("radius", 1.0)),
+                static_cast<float>(run.number("mass", 1e10)), seed);
+        else if (init == "disk")
+            QP::InitializeRotatingDisk(sim, count, static_cast<float>(run.number("inner", 1.0)),
+                static_cast<float>(run.number("outer", 10.0)), static_cast<float>(run.number("central_mass", 1e12)),
+                static_cast<float>(run.number("mass", 1e6)), seed);
+        else
+            throw std::invalid_argument("unknown init " + init);
+
+        for (long i = 0; i < run.steps; ++i) QP::UpdateGravity(sim, static_cast<float>(run.dt));
+
+        double totalMass = 0.0, kinetic = 0.0;
+        double cx = 0.0, cy = 0.0, cz = 0.0;
+        for (const auto& p : sim.particles) {
+            totalMass += p.mass;
+            kinetic += 0.5 * p.mass * (p.velocity.x * p.velocity.x + p.velocity.y * p.velocity.y + p.velocity.z * p.velocity.z);
+            cx += p.mass * p.position.x;
+            cy += p.mass * p.position.y;
+            cz += p.mass * p.position.z;
+        }
+        if (totalMass > 0.0) {
+            cx /= totalMass;
+            cy /= totalMass;
+            cz /= totalMass;
+        }
+
+        double radius = 0.0;
+        for (const auto& p : sim.particles)
+            radius += (p.position.x - cx) * (p.position.x - cx) + (p.position.y - cy) * (p.position.y - cy) + (p.position.z - cz) * (p.position.z - cz);
+        radius = sim.particles.empty() ? 0.0 : std::sqrt(radius / sim.particles.size());
+
+        return { { "kinetic_energy", kinetic }, { "rms_radius", radius } };
+    }
+
+    Metrics RunCloth(const Run& run) {
+        QP::Cloth cloth(static_cast<size_t>(run.dimension("width", 20)), static_cast<size_t>(run.dimension("height", 20)));
+
+        const std::string integrator = run.text("integrator", "verlet");
+        if (integrator == "implicit")
+            cloth.integrator = QP::ClothIntegrator::Implicit;
+        else if (integrator != "verlet")
+            throw std::invalid_argument("unknown integrator " + integrator);
+
+        cloth.stiffness = static_cast<float>(run.number("stiffness", cloth.stiffness));
+        cloth.damping = static_cast<float>(run.number("damping", cloth.damping));
+        cloth.particleMass = static_cast<float>(run.number("mass", cloth.particleMass));
+
+        long sleptAt = -1;
+        for (long i = 0; i < run.steps; ++i) {
+            cloth.update(static_cast<float>(run.dt));
+            if (sleptAt < 0 && cloth.isSleeping()) sleptAt = i + 1;
+        }
+
+        double maxStretch = 0.0, minY = 0.0;
+        for (const auto& c : cloth.constraints)
+            maxStretch = std::max<double>(maxStretch, (cloth.particles[c.first].position - cloth.particles[c.second].position).length() / cloth.restLength);
+        for (size_t i = 0; i < cloth.particles.size(); ++i)
+            minY = i == 0 ? cloth.particles[i].position.y : std::min<double>(minY, cloth.particles[i].position.y);
+
+        return { { "max_stretch", maxStretch }, { "min_y", minY }, { "slept_at", static_cast<double>(sleptAt) } };
+    }
+
+    Metrics RunFluid(const Run& run) {
+        QP::FluidSimulation fluid(run.dimension("width", 80), run.dimension("height", 40));
+        const int sx = static_cast<int>(run.number("source_x", 20));
+        const int sy = static_cast<int>(run.number("source_y", 10));
+        const float smoke = static_cast<float>(run.number("smoke", 0.1));
+        const float u = static_cast<float>(run.number("u", 0.1));
+        const float v = static_cast<float>(run.number("v", 0.0));
+
+        for (long i = 0; i < run.steps; ++i) {
+            fluid.addSmoke(sx, sy, smoke);
+            fluid.addVelocity(sx, sy, u, v);
+            fluid.update(static_cast<float>(run.dt));
+        }
+
+        double total = 0.0, maxSpeed = 0.0;
+        for (const auto& column : fluid.grid) {
+            for (const auto& cell : column) {
+                total += cell.smoke;
+                maxSpeed = std::max<double>(maxSpeed, std::sqrt(cell.velocity.u * cell.velocity.u + cell.velocity.v * cell.velocity.v));
+            }
+        }
+        return { { "total_smoke", total }, { "max_speed", maxSpeed } };
+    }
+
+    Metrics Simulate(const Run& run) {
+        if (run.sim == "pendulum") return RunPendulum(run);
+        if (run.sim == "gravity") return RunGravity(run);
+        if (run.sim == "cloth") return RunCloth(run);
+        if (run.sim == "fluid") return RunFluid(run);
+        throw std::invalid_argument("unknown sim " + run.sim);
+    }
+
+    std::string FormatResult(const Run& run, double wallMs, const Metrics& metrics, const std::string& error) {
+        std::ostringstream line;
+        line.precision(9);
+
+        bool finite = true;
+        for (const auto& metric : metrics) finite = finite && std::isfinite(metric.second);
+
+        line << run.id << ',' << run.sim << ',' << (!error.empty() ? "error" : finite ? "ok" : "nonfinite") << ',' << wallMs << ',';
+        if (!error.empty()) {
+            std::string message = error;
+            std::replace(message.begin(), message.end(), ',', ' ');
+            std::replace(message.begin(), message.end(), '\n', ' ');
+            line << "message=" << message;
+        }
+        for (size_t i = 0; i < metrics.size(); ++i)
+            line << (i ? ";" : "") << metrics[i].first << '=' << metrics[i].second;
+        line << '\n';
+        return line.str();
+    }
+
+}
+
+// Usage: physics_sweep <spec.csv> <results.csv> [--jobs N]
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    size_t jobs = QP::WorkerCount();
+    bool badArguments = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--jobs" && i + 1 < argc) {
+            const std::string value = argv[++i];
+            char* end = nullptr;
+            const long n = std::strtol(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0' || n < 1) {
+                std::cerr << "--jobs expects a positive integer, got '" << value << "'\n";
+                badArguments = true;
+            } else {
+                jobs = static_cast<size_t>(n);
+            }
+        } else {
+            paths.push_back(arg);
+        }
+    }
+
+    if (badArguments || paths.size() != 2) {
+        std::cerr << "Usage: physics_sweep <spec.csv> <results.csv> [--jobs N]\n";
+        return 1;
+    }
+
+    std::vector<Run> runs;
+    std::string error;
+    if (!LoadSpec(paths[0], runs, error)) {
+        std::cerr << error << '\n';
+        return 1;
+    }
+
+    std::set<std::string> finished;
+    if (!LoadFinished(paths[1], finished, error)) {
+        std::cerr << error << '\n';
+        return 1;
+    }
+    std::vector<const Run*> pending;
+    for (const Run& run : runs)
+        if (!finished.count(run.id)) pending.push_back(&run);
+
+    std::error_code sizeError;
+    const bool fresh = std::filesystem::file_size(paths[1], sizeError) == 0 || sizeError;
+    std::ofstream out(paths[1], std::ios::app);
+    if (!out) {
+        std::cerr << "Could not open " << paths[1] << '\n';
+        return 1;
+    }
+    if (fresh) out << "id,sim,status,wall_ms,metrics\n" << std::flush;
+
+    std::cerr << runs.size() << " runs, " << runs.size() - pending.size() << " already ok, "
+              << std::min(jobs, pending.size()) << " workers\n";
+
+    std::atomic<size_t> next{0};
+    std::mutex outputMutex;
+    size_t done = 0;
+
+    auto worker = [&]() {
+        // Runs already fill every core; nested parallel loops would only oversubscribe.
+        QP::WorkerLimit() = 1;
+
+        for (size_t i = next++; i < pending.size(); i = next++) {
+            const Run& run = *pending[i];
+            Metrics metrics;
+            std::string failure;
+
+            const auto start = std::chrono::steady_clock::now();
+            try {
+                metrics = Simulate(run);
+            } catch (const std::exception& e) {
+                failure = e.what();
+            }
+            const double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            const std::string line = FormatResult(run, wallMs, metrics, failure);
+            std::lock_guard<std::mutex> lock(outputMutex);
+            out << line << std::flush;
+            std::cerr << '[' << ++done << '/' << pending.size() << "] " << run.id << '\n';
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t w = 1; w < std::min(jobs, pending.size()); ++w) workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers) thread.join();
+
+    return out ? 0 : 1;
+}
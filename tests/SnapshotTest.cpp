@@ -0,0 +1,61 @@
+#include "Snapshot.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Overlapping writeAsync calls to one path, as in a checkpoint loop that
+// starts the next write before the previous future is destroyed. Every write
+// must succeed and the file must always hold one complete snapshot.
+static bool OverlappingWrites(const std::string& path) {
+    constexpr int Rounds = 10;
+    constexpr int Overlap = 4;
+    constexpr size_t Count = 1 << 16;
+
+    for (int round = 0; round < Rounds; ++round) {
+        std::vector<std::future<bool>> pending;
+        for (int i = 0; i < Overlap; ++i) {
+            QP::SnapshotWriter writer;
+            const int32_t stamp = round * Overlap + i;
+            int32_t* data = writer.addSection<int32_t>("data", QP::SnapshotType::Int32, Count);
+            for (size_t k = 0; k < Count; ++k) data[k] = stamp;
+            pending.push_back(writer.writeAsync(path));
+        }
+
+        for (auto& future : pending) {
+            if (!future.get()) {
+                std::cerr << "round " << round << ": writeAsync returned false\n";
+                return false;
+            }
+        }
+
+        QP::SnapshotReader reader;
+        size_t count = 0;
+        const int32_t* data = reader.open(path) ? reader.view<int32_t>("data", count) : nullptr;
+        if (!data || count != Count) {
+            std::cerr << "round " << round << ": snapshot unreadable\n";
+            return false;
+        }
+        for (size_t k = 1; k < Count; ++k) {
+            if (data[k] != data[0]) {
+                std::cerr << "round " << round << ": snapshot mixes two writes\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const std::string dir = argc > 1 ? argv[1] : ".";
+    const std::string path = dir + "/overlap.snap";
+
+    const bool ok = OverlappingWrites(path);
+    std::remove(path.c_str());
+
+    std::cout << (ok ? "PASS" : "FAIL") << " overlapping snapshot writes\n";
+    return ok ? 0 : 1;
+}